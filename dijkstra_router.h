@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "graph.h"
+#include "router.h"
+
+namespace graph {
+
+	// Движок, который не делает предрасчета: каждый запрос
+	// обрабатывается алгоритмом Дейкстры из вершины from,
+	// а готовые ответы хранятся в LRU-кэше ограниченного размера
+	template <typename Weight>
+	class DijkstraRouter final : public RouterBase<Weight> {
+	private:
+		using Graph = DirectedWeightedGraph<Weight>;
+
+	public:
+		using RouteInfo = graph::RouteInfo<Weight>;
+
+		DijkstraRouter(const Graph& graph, size_t cache_size);
+
+		std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+	private:
+		using CacheKey = std::uint64_t;
+		using CacheEntry = std::pair<CacheKey, std::optional<RouteInfo>>;
+		using QueueEntry = std::pair<Weight, VertexId>;
+
+		static constexpr Weight ZERO_WEIGHT{};
+		static constexpr EdgeId NO_EDGE = static_cast<EdgeId>(-1);
+
+		const Graph& graph_;
+		size_t cache_size_;
+
+		// Кэш ответов: в начале списка - последние использованные
+		mutable std::list<CacheEntry> cache_;
+		mutable std::unordered_map<CacheKey, typename std::list<CacheEntry>::iterator> cache_index_;
+
+		// Рабочие массивы поиска. Чтобы не очищать их на каждом запросе,
+		// вершина считается посещенной в текущем поиске только если
+		// ее метка совпадает с номером поиска
+		mutable std::vector<Weight> weights_;
+		mutable std::vector<EdgeId> prev_edges_;
+		mutable std::vector<std::uint32_t> marks_;
+		mutable std::uint32_t current_mark_ = 0;
+
+		static CacheKey MakeKey_(VertexId from, VertexId to) {
+			return (static_cast<CacheKey>(from) << 32) | static_cast<CacheKey>(to);
+		}
+
+		// Поиск кратчайшего пути с остановкой при извлечении вершины to
+		std::optional<RouteInfo> FindRoute_(VertexId from, VertexId to) const;
+
+		void PutToCache_(CacheKey key, const std::optional<RouteInfo>& route) const;
+	};
+
+	template <typename Weight>
+	DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph, size_t cache_size)
+		: graph_(graph)
+		, cache_size_(cache_size)
+		, weights_(graph.GetVertexCount())
+		, prev_edges_(graph.GetVertexCount(), NO_EDGE)
+		, marks_(graph.GetVertexCount(), 0) {
+		CheckGraphForShortestPaths(graph);
+	}
+
+	template <typename Weight>
+	std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+		VertexId to) const {
+		if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+			throw std::out_of_range("Vertex id is out of range");
+		}
+
+		const CacheKey key = MakeKey_(from, to);
+		if (auto it = cache_index_.find(key); it != cache_index_.end()) {
+			cache_.splice(cache_.begin(), cache_, it->second);
+			return it->second->second;
+		}
+
+		std::optional<RouteInfo> route = FindRoute_(from, to);
+		PutToCache_(key, route);
+		return route;
+	}
+
+	template <typename Weight>
+	std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::FindRoute_(VertexId from,
+		VertexId to) const {
+		if (++current_mark_ == 0) {
+			// Номера поисков закончились - сбрасываем метки
+			std::fill(marks_.begin(), marks_.end(), 0);
+			current_mark_ = 1;
+		}
+
+		std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+		weights_[from] = ZERO_WEIGHT;
+		prev_edges_[from] = NO_EDGE;
+		marks_[from] = current_mark_;
+		queue.push({ ZERO_WEIGHT, from });
+
+		bool is_found = false;
+		while (!queue.empty()) {
+			const auto [weight, vertex] = queue.top();
+			queue.pop();
+			if (weights_[vertex] < weight) {
+				// Устаревшая запись: вершину уже достали с меньшим весом
+				continue;
+			}
+			if (vertex == to) {
+				is_found = true;
+				break;
+			}
+			for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+				const auto& edge = graph_.GetEdge(edge_id);
+				const Weight candidate_weight = weight + edge.weight;
+				if (marks_[edge.to] != current_mark_ || candidate_weight < weights_[edge.to]) {
+					marks_[edge.to] = current_mark_;
+					weights_[edge.to] = candidate_weight;
+					prev_edges_[edge.to] = edge_id;
+					queue.push({ candidate_weight, edge.to });
+				}
+			}
+		}
+
+		if (!is_found) {
+			return std::nullopt;
+		}
+
+		std::vector<EdgeId> edges;
+		for (EdgeId edge_id = prev_edges_[to]; edge_id != NO_EDGE; edge_id = prev_edges_[graph_.GetEdge(edge_id).from]) {
+			edges.push_back(edge_id);
+		}
+		std::reverse(edges.begin(), edges.end());
+
+		return RouteInfo{ weights_[to], std::move(edges) };
+	}
+
+	template <typename Weight>
+	void DijkstraRouter<Weight>::PutToCache_(CacheKey key, const std::optional<RouteInfo>& route) const {
+		if (cache_size_ == 0) {
+			return;
+		}
+		if (cache_.size() == cache_size_) {
+			cache_index_.erase(cache_.back().first);
+			cache_.pop_back();
+		}
+		cache_.emplace_front(key, route);
+		cache_index_[key] = cache_.begin();
+	}
+
+	// Движок, который при первом запросе из вершины from строит полное
+	// дерево кратчайших путей из нее и отвечает по нему на все
+	// последующие запросы BuildRoute(from, *).
+	// rows_limit ограничивает число хранимых строк (0 - без ограничения),
+	// при переполнении вытесняется давно не использованная строка
+	template <typename Weight>
+	class LazyRouter final : public RouterBase<Weight> {
+	private:
+		using Graph = DirectedWeightedGraph<Weight>;
+
+	public:
+		using RouteInfo = graph::RouteInfo<Weight>;
+
+		LazyRouter(const Graph& graph, size_t rows_limit);
+
+		std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+	private:
+		using RowsEntry = std::pair<VertexId, ShortestPathRow<Weight>>;
+
+		const Graph& graph_;
+		size_t rows_limit_;
+
+		// В начале списка - последние использованные строки
+		mutable std::list<RowsEntry> rows_;
+		mutable std::unordered_map<VertexId, typename std::list<RowsEntry>::iterator> rows_index_;
+
+		const ShortestPathRow<Weight>& GetRow_(VertexId from) const;
+	};
+
+	template <typename Weight>
+	LazyRouter<Weight>::LazyRouter(const Graph& graph, size_t rows_limit)
+		: graph_(graph)
+		, rows_limit_(rows_limit) {
+		CheckGraphForShortestPaths(graph);
+	}
+
+	template <typename Weight>
+	std::optional<typename LazyRouter<Weight>::RouteInfo> LazyRouter<Weight>::BuildRoute(VertexId from,
+		VertexId to) const {
+		const ShortestPathRow<Weight>& row = GetRow_(from);
+		if (row.prev_edges.at(to) == UNREACHABLE) {
+			return std::nullopt;
+		}
+
+		std::vector<EdgeId> edges;
+		for (CompactEdgeId edge_id = row.prev_edges[to]; edge_id != NO_PREV_EDGE;
+			edge_id = row.prev_edges[graph_.GetEdge(edge_id).from]) {
+			edges.push_back(edge_id);
+		}
+		std::reverse(edges.begin(), edges.end());
+
+		return RouteInfo{ row.weights[to], std::move(edges) };
+	}
+
+	template <typename Weight>
+	const ShortestPathRow<Weight>& LazyRouter<Weight>::GetRow_(VertexId from) const {
+		if (auto it = rows_index_.find(from); it != rows_index_.end()) {
+			rows_.splice(rows_.begin(), rows_, it->second);
+			return it->second->second;
+		}
+
+		if (from >= graph_.GetVertexCount()) {
+			throw std::out_of_range("Vertex id is out of range");
+		}
+		if (rows_limit_ != 0 && rows_.size() == rows_limit_) {
+			rows_index_.erase(rows_.back().first);
+			rows_.pop_back();
+		}
+		rows_.emplace_front(from, BuildShortestPathRow(graph_, from));
+		rows_index_[from] = rows_.begin();
+
+		return rows_.front().second;
+	}
+
+}  // namespace graph
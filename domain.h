@@ -1,9 +1,9 @@
 #pragma once
 
 #include <string>
-#include <memory>
-#include <deque>
 #include <set>
+#include <vector>
+#include <cstdint>
 #include <iomanip>
 
 #include "graph.h"
@@ -15,19 +15,33 @@ extern const std::string RouteRequest;
 
 std::string DoubleToString(double value);
 
+// Номера остановок и маршрутов совпадают с их индексами в хранилищах каталога
+using StopId = std::uint32_t;
+using BusId = std::uint32_t;
+
 struct Stop {
 	Stop() = default;
 
 	std::string name;
 	double coord_x = 0;
 	double coord_y = 0;
-	graph::VertexId id;
+	StopId id = 0;
 	std::set<std::string> buses;
 };
 
+// Статистика маршрута, считается один раз при построении базы
+struct BusStats {
+	double route_length = 0;
+	double curvature = 0;
+	int stop_count = 0;
+	int unique_stop_count = 0;
+};
+
 struct Bus {
-	bool is_looped;
+	bool is_looped = false;
 	std::string name;
-	graph::VertexId id;
-	std::deque<std::shared_ptr<Stop>> stops;
+	BusId id = 0;
+	// Номера остановок; некольцевой маршрут хранится вместе с обратным путем
+	std::vector<StopId> stops;
+	BusStats stats;
 };
\ No newline at end of file
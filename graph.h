@@ -1,6 +1,9 @@
 #pragma once
 
 #include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include "ranges.h"
@@ -18,64 +21,148 @@ namespace graph {
 		Weight weight;
 	};
 
+	// Списки инцидентности хранятся в сжатом виде (CSR): номера ребер всех
+	// вершин лежат подряд в одном массиве, а ребра вершины v занимают
+	// в нем отрезок [incidence_offsets[v], incidence_offsets[v + 1]).
+	// Массивы либо принадлежат графу, либо лежат в чужой памяти
+	// (например, в отображенном в память файле базы) - см. View
 	template <typename Weight>
 	class DirectedWeightedGraph {
 	public:
-		using IncidenceList = std::vector<EdgeId>;
-		using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+		using IncidentEdgesRange = ranges::Range<const EdgeId*>;
 
-		DirectedWeightedGraph() = default;
+		DirectedWeightedGraph();
 		explicit DirectedWeightedGraph(size_t vertex_count);
-		EdgeId AddEdge(const Edge<Weight>& edge);
+
+		// Граф по списку ребер: списки инцидентности строятся за один проход,
+		// номера ребер совпадают с их местами в списке
+		DirectedWeightedGraph(size_t vertex_count, std::vector<Edge<Weight>> edges);
+
+		// Граф поверх чужих массивов без копирования. owner продлевает
+		// жизнь памяти, в которой они лежат
+		static DirectedWeightedGraph View(size_t vertex_count, size_t edge_count, const Edge<Weight>* edges,
+			const EdgeId* incidence_offsets, const EdgeId* incidence_edges, std::shared_ptr<const void> owner);
+
+		// Указатели смотрят в собственные массивы, поэтому копирование
+		// запрещено, а перемещение их сохраняет
+		DirectedWeightedGraph(const DirectedWeightedGraph&) = delete;
+		DirectedWeightedGraph& operator=(const DirectedWeightedGraph&) = delete;
+		DirectedWeightedGraph(DirectedWeightedGraph&&) = default;
+		DirectedWeightedGraph& operator=(DirectedWeightedGraph&&) = default;
 
 		size_t GetVertexCount() const;
 		size_t GetEdgeCount() const;
 		const Edge<Weight>& GetEdge(EdgeId edge_id) const;
 		IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
-		std::vector<Edge<Weight>>& GetEdges(){
+		// Сырые массивы - для сериализации
+		const Edge<Weight>* GetEdgesData() const {
 			return edges_;
 		}
-		std::vector<IncidenceList>& GetIncidenceLists(){
-			return incidence_lists_;
+		// vertex_count + 1 элементов
+		const EdgeId* GetIncidenceOffsetsData() const {
+			return incidence_offsets_;
+		}
+		const EdgeId* GetIncidenceEdgesData() const {
+			return incidence_edges_;
 		}
 
 	private:
-		std::vector<Edge<Weight>> edges_;
-		std::vector<IncidenceList> incidence_lists_;
+		std::vector<Edge<Weight>> edges_storage_;
+		std::vector<EdgeId> incidence_offsets_storage_;
+		std::vector<EdgeId> incidence_edges_storage_;
+		std::shared_ptr<const void> owner_;
+
+		size_t vertex_count_ = 0;
+		size_t edge_count_ = 0;
+		const Edge<Weight>* edges_ = nullptr;
+		const EdgeId* incidence_offsets_ = nullptr;
+		const EdgeId* incidence_edges_ = nullptr;
+
+		// Направляет указатели на собственные массивы
+		void BindStorage_();
 	};
 
+	template <typename Weight>
+	DirectedWeightedGraph<Weight>::DirectedWeightedGraph()
+		: DirectedWeightedGraph(0) {
+	}
+
 	template <typename Weight>
 	DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-		: incidence_lists_(vertex_count) {
+		: incidence_offsets_storage_(vertex_count + 1, 0) {
+		BindStorage_();
+	}
+
+	template <typename Weight>
+	DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count, std::vector<Edge<Weight>> edges)
+		: edges_storage_(std::move(edges))
+		, incidence_offsets_storage_(vertex_count + 1, 0)
+		, incidence_edges_storage_(edges_storage_.size()) {
+		for (const Edge<Weight>& edge : edges_storage_) {
+			if (edge.from >= vertex_count || edge.to >= vertex_count) {
+				throw std::out_of_range("Edge is out of the graph");
+			}
+			++incidence_offsets_storage_[edge.from + 1];
+		}
+		for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+			incidence_offsets_storage_[vertex + 1] += incidence_offsets_storage_[vertex];
+		}
+		// Ребра раскладываются по возрастанию номеров, как при поочередном добавлении
+		std::vector<EdgeId> positions(incidence_offsets_storage_.begin(), incidence_offsets_storage_.end() - 1);
+		for (EdgeId edge_id = 0; edge_id < edges_storage_.size(); ++edge_id) {
+			incidence_edges_storage_[positions[edges_storage_[edge_id].from]++] = edge_id;
+		}
+		BindStorage_();
 	}
 
 	template <typename Weight>
-	EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
-		edges_.push_back(edge);
-		const EdgeId id = edges_.size() - 1;
-		incidence_lists_.at(edge.from).push_back(id);
-		return id;
+	DirectedWeightedGraph<Weight> DirectedWeightedGraph<Weight>::View(size_t vertex_count, size_t edge_count,
+		const Edge<Weight>* edges, const EdgeId* incidence_offsets, const EdgeId* incidence_edges,
+		std::shared_ptr<const void> owner) {
+		DirectedWeightedGraph graph;
+		graph.owner_ = std::move(owner);
+		graph.vertex_count_ = vertex_count;
+		graph.edge_count_ = edge_count;
+		graph.edges_ = edges;
+		graph.incidence_offsets_ = incidence_offsets;
+		graph.incidence_edges_ = incidence_edges;
+		return graph;
+	}
+
+	template <typename Weight>
+	void DirectedWeightedGraph<Weight>::BindStorage_() {
+		vertex_count_ = incidence_offsets_storage_.size() - 1;
+		edge_count_ = edges_storage_.size();
+		edges_ = edges_storage_.data();
+		incidence_offsets_ = incidence_offsets_storage_.data();
+		incidence_edges_ = incidence_edges_storage_.data();
 	}
 
 	template <typename Weight>
 	size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-		return incidence_lists_.size();
+		return vertex_count_;
 	}
 
 	template <typename Weight>
 	size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
-		return edges_.size();
+		return edge_count_;
 	}
 
 	template <typename Weight>
 	const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
-		return edges_.at(edge_id);
+		if (edge_id >= edge_count_) {
+			throw std::out_of_range("Edge id is out of range");
+		}
+		return edges_[edge_id];
 	}
 
 	template <typename Weight>
 	typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 		DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-		return ranges::AsRange(incidence_lists_.at(vertex));
+		if (vertex >= vertex_count_) {
+			throw std::out_of_range("Vertex id is out of range");
+		}
+		return { incidence_edges_ + incidence_offsets_[vertex], incidence_edges_ + incidence_offsets_[vertex + 1] };
 	}
-}  // namespace graph
\ No newline at end of file
+}  // namespace graph
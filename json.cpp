@@ -1,4 +1,10 @@
+#include <cctype>
+#include <charconv>
+#include <cstring>
 #include <iterator>
+#include <algorithm>
+#include <limits>
+#include <system_error>
 
 #include "json.h"
 
@@ -7,150 +13,223 @@ namespace json {
 	namespace {
 		using namespace std::literals;
 
-		Node LoadNode(std::istream& input);
-		Node LoadString(std::istream& input);
+		// Разбираемый текст целиком в памяти. Разбор идет по указателю
+		// без копирования во временные строки, кроме значений строк
+		struct Input {
+			const char* pos;
+			const char* end;
+			// Общие для всех уровней вложенности стеки элементов: массив или
+			// словарь копит элементы на вершине стека и забирает их одним
+			// блоком точного размера, без роста собственного вектора
+			std::vector<Node> array_items = {};
+			std::vector<Dict::value_type> dict_items = {};
+		};
+
+		// Переносит элементы стека, начиная с first, в вектор точного размера
+		template <typename Item>
+		std::vector<Item> TakeItems(std::vector<Item>& stack, size_t first) {
+			std::vector<Item> items(std::make_move_iterator(stack.begin() + first), std::make_move_iterator(stack.end()));
+			stack.erase(stack.begin() + first, stack.end());
+			return items;
+		}
+
+		Node LoadNode(Input& input);
+
+		bool IsSpace(char character) {
+			return character == ' ' || character == '\n' || character == '\r' || character == '\t'
+				|| character == '\v' || character == '\f';
+		}
+
+		bool IsDigit(const Input& input) {
+			return input.pos != input.end && *input.pos >= '0' && *input.pos <= '9';
+		}
+
+		// Пропускает пробельные символы и возвращает следующий символ, не извлекая его
+		char PeekNonSpace(Input& input) {
+			while (input.pos != input.end && IsSpace(*input.pos)) {
+				++input.pos;
+			}
+			if (input.pos == input.end) {
+				throw ParsingError("Unexpected EOF"s);
+			}
+			return *input.pos;
+		}
 
-		std::string LoadLiteral(std::istream& input) {
-			std::string result_literal;
-			while (std::isalpha(input.peek())) {
-				result_literal.push_back(static_cast<char>(input.get()));
+		std::string_view LoadLiteral(Input& input) {
+			const char* begin = input.pos;
+			while (input.pos != input.end && std::isalpha(static_cast<unsigned char>(*input.pos))) {
+				++input.pos;
 			}
-			return result_literal;
+			return { begin, static_cast<size_t>(input.pos - begin) };
 		}
 
-		Node LoadArray(std::istream& input) {
-			std::vector<Node> result;
+		std::string LoadString(Input& input);
 
-			for (char character; input >> character && character != ']';) {
+		Node LoadArray(Input& input) {
+			if (PeekNonSpace(input) == ']') {
+				++input.pos;
+				return Node(Array());
+			}
+
+			const size_t first = input.array_items.size();
+			while (true) {
+				input.array_items.push_back(LoadNode(input));
+				const char character = PeekNonSpace(input);
+				++input.pos;
+				if (character == ']') {
+					break;
+				}
 				if (character != ',') {
-					input.putback(character);
+					throw ParsingError(R"(',' is expected but ')"s + character + "' has been found"s);
 				}
-				result.push_back(LoadNode(input));
 			}
-			if (!input) {
-				throw ParsingError("Array parsing error"s);
+			return Node(TakeItems(input.array_items, first));
+		}
+
+		Node LoadDict(Input& input) {
+			if (PeekNonSpace(input) == '}') {
+				++input.pos;
+				return Node(Dict());
 			}
-			return Node(std::move(result));
-		}
-
-		Node LoadDict(std::istream& input) {
-			Dict dict;
-
-			for (char character; input >> character && character != '}';) {
-				if (character == '"') {
-					std::string key = LoadString(input).AsString();
-					if (input >> character && character == ':') {
-						if (dict.find(key) != dict.end()) {
-							throw ParsingError("Duplicate key '"s + key + "' have been found"s);
-						}
-						dict.emplace(std::move(key), LoadNode(input));
-					} else {
-						throw ParsingError(": is expected but '"s + character + "' has been found"s);
-					}
-				} else if (character != ',') {
+
+			// Пары собираются подряд и сортируются один раз в конце
+			const size_t first = input.dict_items.size();
+			while (true) {
+				char character = PeekNonSpace(input);
+				++input.pos;
+				if (character != '"') {
+					throw ParsingError(R"('"' is expected but ')"s + character + "' has been found"s);
+				}
+				std::string key = LoadString(input);
+				if (character = PeekNonSpace(input); character != ':') {
+					throw ParsingError(": is expected but '"s + character + "' has been found"s);
+				}
+				++input.pos;
+				input.dict_items.emplace_back(std::move(key), LoadNode(input));
+
+				character = PeekNonSpace(input);
+				++input.pos;
+				if (character == '}') {
+					break;
+				}
+				if (character != ',') {
 					throw ParsingError(R"(',' is expected but ')"s + character + "' has been found"s);
 				}
 			}
-			if (!input) {
-				throw ParsingError("Dictionary parsing error"s);
+
+			const auto items_begin = input.dict_items.begin() + first;
+			std::sort(items_begin, input.dict_items.end(), [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+				return lhs.first < rhs.first;
+			});
+			const auto duplicate = std::adjacent_find(items_begin, input.dict_items.end(),
+				[](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+					return lhs.first == rhs.first;
+				});
+			if (duplicate != input.dict_items.end()) {
+				throw ParsingError("Duplicate key '"s + duplicate->first + "' have been found"s);
 			}
-			return Node(std::move(dict));
+			return Node(Dict(TakeItems(input.dict_items, first)));
 		}
 
-		Node LoadString(std::istream& input) {
-			auto it = std::istreambuf_iterator<char>(input);
-			auto end = std::istreambuf_iterator<char>();
+		// Первое вхождение символа в [begin, end) или end
+		const char* FindChar(const char* begin, const char* end, char character) {
+			const void* found = std::memchr(begin, character, end - begin);
+			return found ? static_cast<const char*>(found) : end;
+		}
+
+		std::string LoadString(Input& input) {
 			std::string input_string;
 			while (true) {
-				if (it == end) {
+				// Закрывающая кавычка и особые символы ищутся memchr, а куски
+				// обычного текста между ними копируются в строку целиком
+				const char* quote = static_cast<const char*>(std::memchr(input.pos, '"', input.end - input.pos));
+				if (quote == nullptr) {
 					throw ParsingError("String parsing error");
 				}
-				const char ch = *it;
-				if (ch == '"') {
-					++it;
+				const char* special = FindChar(input.pos, quote, '\\');
+				special = FindChar(input.pos, special, '\n');
+				special = FindChar(input.pos, special, '\r');
+				input_string.append(input.pos, special);
+				input.pos = special;
+				if (special == quote) {
+					++input.pos;
 					break;
-				} else if (ch == '\\') {
-					++it;
-					if (it == end) {
-						throw ParsingError("String parsing error");
-					}
-					const char escaped_char = *(it);
-					switch (escaped_char) {
-					case 'n':
-						input_string.push_back('\n');
-						break;
-					case 't':
-						input_string.push_back('\t');
-						break;
-					case 'r':
-						input_string.push_back('\r');
-						break;
-					case '"':
-						input_string.push_back('"');
-						break;
-					case '\\':
-						input_string.push_back('\\');
-						break;
-					default:
-						throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
-					}
-				} else if (ch == '\n' || ch == '\r') {
+				}
+				if (*special != '\\') {
 					throw ParsingError("Unexpected end of line"s);
-				} else {
-					input_string.push_back(ch);
 				}
-				++it;
+
+				// Экранированный символ. Кавычка за \ не закрывает строку,
+				// поэтому после него поиск начинается заново
+				if (++input.pos == input.end) {
+					throw ParsingError("String parsing error");
+				}
+				const char escaped_char = *input.pos++;
+				switch (escaped_char) {
+				case 'n':
+					input_string.push_back('\n');
+					break;
+				case 't':
+					input_string.push_back('\t');
+					break;
+				case 'r':
+					input_string.push_back('\r');
+					break;
+				case '"':
+					input_string.push_back('"');
+					break;
+				case '\\':
+					input_string.push_back('\\');
+					break;
+				default:
+					throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+				}
 			}
 
-			return Node(std::move(input_string));
+			return input_string;
 		}
 
-		Node LoadBool(std::istream& input) {
-			const std::string literal = LoadLiteral(input);
+		Node LoadBool(Input& input) {
+			const std::string_view literal = LoadLiteral(input);
 			if (literal == "true"sv) {
 				return Node{ true };
 			} else if (literal == "false"sv) {
 				return Node{ false };
 			} else {
-				throw ParsingError("Failed to parse '"s + literal + "' as bool"s);
+				throw ParsingError("Failed to parse '"s + std::string(literal) + "' as bool"s);
 			}
 		}
 
-		Node LoadNull(std::istream& input) {
-			if (std::string literal = LoadLiteral(input); literal == "null"sv) {
+		Node LoadNull(Input& input) {
+			if (const std::string_view literal = LoadLiteral(input); literal == "null"sv) {
 				return Node{ nullptr };
 			} else {
-				throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+				throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
 			}
 		}
 
-		Node LoadNumber(std::istream& input) {
-			std::string parsed_num;
+		Node LoadNumber(Input& input) {
+			const char* begin = input.pos;
 
-			// Считывает в parsed_num очередной символ из input
-			auto read_char = [&parsed_num, &input] {
-				parsed_num += static_cast<char>(input.get());
-				if (!input) {
-					throw ParsingError("Failed to read number from stream"s);
-				}
-			};
-
-			// Считывает одну или более цифр в parsed_num из input
-			auto read_digits = [&input, read_char] {
-				if (!std::isdigit(input.peek())) {
+			// Пропускает одну или более цифр
+			auto read_digits = [&input] {
+				if (!IsDigit(input)) {
 					throw ParsingError("A digit is expected"s);
 				}
-				while (std::isdigit(input.peek())) {
-					read_char();
+				while (IsDigit(input)) {
+					++input.pos;
 				}
 			};
+			auto next_is = [&input](char character) {
+				return input.pos != input.end && *input.pos == character;
+			};
 
-			if (input.peek() == '-') {
-				read_char();
+			if (next_is('-')) {
+				++input.pos;
 			}
 			// Парсим целую часть числа
-			if (input.peek() == '0') {
-				read_char();
+			if (next_is('0')) {
+				++input.pos;
 				// После 0 в JSON не могут идти другие цифры
 			} else {
 				read_digits();
@@ -158,49 +237,49 @@ namespace json {
 
 			bool is_int = true;
 			// Парсим дробную часть числа
-			if (input.peek() == '.') {
-				read_char();
+			if (next_is('.')) {
+				++input.pos;
 				read_digits();
 				is_int = false;
 			}
 
 			// Парсим экспоненциальную часть числа
-			if (int character = input.peek(); character == 'e' || character == 'E') {
-				read_char();
-				if (character = input.peek(); character == '+' || character == '-') {
-					read_char();
+			if (next_is('e') || next_is('E')) {
+				++input.pos;
+				if (next_is('+') || next_is('-')) {
+					++input.pos;
 				}
 				read_digits();
 				is_int = false;
 			}
 
-			try {
-				if (is_int) {
-					// Сначала пробуем преобразовать строку в int
-					try {
-						return std::stoi(parsed_num);
-					} catch (...) {
-						// В случае неудачи, например, при переполнении
-						// код ниже попробует преобразовать строку в double
-					}
+			// Текст числа уже проверен, from_chars преобразует его на месте
+			if (is_int) {
+				int value = 0;
+				if (auto [end, error] = std::from_chars(begin, input.pos, value); error == std::errc{} && end == input.pos) {
+					return value;
 				}
-				return std::stod(parsed_num);
-			} catch (...) {
-				throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+				// В случае неудачи, например, при переполнении
+				// код ниже попробует преобразовать строку в double
+			}
+			double value = 0;
+			if (auto [end, error] = std::from_chars(begin, input.pos, value); error != std::errc{} || end != input.pos) {
+				throw ParsingError("Failed to convert "s + std::string(begin, input.pos) + " to number"s);
 			}
+			return value;
 		}
 
-		Node LoadNode(std::istream& input) {
-			char character;
-			if (!(input >> character)) {
-				throw ParsingError("Unexpected EOF"s);
-			}
+		Node LoadNode(Input& input) {
+			const char character = PeekNonSpace(input);
 			switch (character) {
 			case '[':
+				++input.pos;
 				return LoadArray(input);
 			case '{':
+				++input.pos;
 				return LoadDict(input);
 			case '"':
+				++input.pos;
 				return LoadString(input);
 			case 't':
 				// Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
@@ -211,33 +290,72 @@ namespace json {
 				// литералов true либо false
 				[[fallthrough]];
 			case 'f':
-				input.putback(character);
 				return LoadBool(input);
 			case 'n':
-				input.putback(character);
 				return LoadNull(input);
 			default:
-				input.putback(character);
 				return LoadNumber(input);
 			}
 		}
 
+		constexpr int INDENT_STEP = 4;
+
 		struct PrintContext {
 			std::ostream& out;
-			int indent_step = 4;
+			int indent_step = INDENT_STEP;
 			int indent = 0;
+			// В компактном виде нет ни переводов строк, ни отступов
+			bool is_compact = false;
 
 			void PrintIndent() const {
-				for (int i = 0; i < indent; ++i) {
-					out.put(' ');
+				if (is_compact) {
+					return;
+				}
+				// Пробелы пишутся кусками, а не по одному
+				static constexpr std::string_view SPACES = "                                "sv;
+				for (int left = indent; left > 0; left -= static_cast<int>(SPACES.size())) {
+					out.write(SPACES.data(), std::min(left, static_cast<int>(SPACES.size())));
+				}
+			}
+
+			void PrintLineBreak() const {
+				if (!is_compact) {
+					out.put('\n');
 				}
 			}
 
 			PrintContext Indented() const {
-				return { out, indent_step, indent_step + indent };
+				return { out, indent_step, indent_step + indent, is_compact };
 			}
 		};
 
+		PrintContext MakePrintContext(std::ostream& out, size_t depth, Format format) {
+			return { out, INDENT_STEP, INDENT_STEP * static_cast<int>(depth), format == Format::COMPACT };
+		}
+
+		// Начало массива или словаря
+		void PrintOpening(char bracket, const PrintContext& ctx) {
+			ctx.out.put(bracket);
+			ctx.PrintLineBreak();
+		}
+
+		// Разделитель элементов массива или словаря
+		void PrintSeparator(const PrintContext& ctx) {
+			ctx.out.put(',');
+			ctx.PrintLineBreak();
+		}
+
+		// Конец массива или словаря; ctx - контекст самого контейнера
+		void PrintClosing(char bracket, const PrintContext& ctx) {
+			ctx.PrintLineBreak();
+			ctx.PrintIndent();
+			ctx.out.put(bracket);
+		}
+
+		void PrintKeySeparator(const PrintContext& ctx) {
+			ctx.out << (ctx.is_compact ? ":"sv : ": "sv);
+		}
+
 		void PrintNode(const Node& value, const PrintContext& ctx);
 
 		template <typename Value>
@@ -245,7 +363,7 @@ namespace json {
 			ctx.out << value;
 		}
 
-		void PrintString(const std::string& value, std::ostream& out) {
+		void PrintString(std::string_view value, std::ostream& out) {
 			out.put('"');
 			for (const char character : value) {
 				switch (character) {
@@ -274,6 +392,23 @@ namespace json {
 			PrintString(value, ctx.out);
 		}
 
+		// Числа форматируются to_chars без обращения к локали потока.
+		// double - как operator<< с точностью по умолчанию (%g, 6 знаков)
+		template <>
+		void PrintValue<int>(const int& value, const PrintContext& ctx) {
+			char buffer[std::numeric_limits<int>::digits10 + 3];
+			const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+			ctx.out.write(buffer, result.ptr - buffer);
+		}
+
+		template <>
+		void PrintValue<double>(const double& value, const PrintContext& ctx) {
+			constexpr int DOUBLE_PRECISION = 6;
+			char buffer[32];
+			const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, DOUBLE_PRECISION);
+			ctx.out.write(buffer, result.ptr - buffer);
+		}
+
 		template <>
 		void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
 			ctx.out << "null"sv;
@@ -290,63 +425,143 @@ namespace json {
 
 		template <>
 		void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
-			std::ostream& out = ctx.out;
-			out << "[\n"sv;
+			PrintOpening('[', ctx);
 			bool first = true;
 			auto inner_ctx = ctx.Indented();
 			for (const Node& node : nodes) {
 				if (first) {
 					first = false;
 				} else {
-					out << ",\n"sv;
+					PrintSeparator(ctx);
 				}
 				inner_ctx.PrintIndent();
 				PrintNode(node, inner_ctx);
 			}
-			out.put('\n');
-			ctx.PrintIndent();
-			out.put(']');
+			PrintClosing(']', ctx);
 		}
 
 		template <>
 		void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
-			std::ostream& out = ctx.out;
-			out << "{\n"sv;
+			PrintOpening('{', ctx);
 			bool first = true;
 			auto inner_ctx = ctx.Indented();
 			for (const auto& [key, node] : nodes) {
 				if (first) {
 					first = false;
 				} else {
-					out << ",\n"sv;
+					PrintSeparator(ctx);
 				}
 				inner_ctx.PrintIndent();
 				PrintString(key, ctx.out);
-				out << ": "sv;
+				PrintKeySeparator(ctx);
 				PrintNode(node, inner_ctx);
 			}
-			out.put('\n');
-			ctx.PrintIndent();
-			out.put('}');
+			PrintClosing('}', ctx);
 		}
 
 		void PrintNode(const Node& node, const PrintContext& ctx) {
 			std::visit(
 				[&ctx](const auto& value) {
 					PrintValue(value, ctx);
-					ctx.out;
 				},
 				node.GetValue());
 		}
 
 	}  // namespace
 
+	Document Load(std::string_view input) {
+		Input parser_input{ input.data(), input.data() + input.size() };
+		return Document{ LoadNode(parser_input) };
+	}
+
 	Document Load(std::istream& input) {
-		return Document{ LoadNode(input) };
+		// Поток читается целиком крупными кусками, а разбирается уже буфер
+		std::string buffer;
+		char chunk[1 << 16];
+		while (input.read(chunk, sizeof(chunk)) || input.gcount() > 0) {
+			buffer.append(chunk, static_cast<size_t>(input.gcount()));
+		}
+		return Load(std::string_view(buffer));
+	}
+
+	void Print(const Document& doc, std::ostream& output, Format format) {
+		PrintNode(doc.GetRoot(), MakePrintContext(output, 0, format));
 	}
 
-	void Print(const Document& doc, std::ostream& output) {
-		PrintNode(doc.GetRoot(), PrintContext{ output });
+	Writer& Writer::StartArray() {
+		BeforeValue_();
+		PrintOpening('[', MakePrintContext(output_, containers_.size(), format_));
+		containers_.push_back({ false });
+		return *this;
+	}
+
+	Writer& Writer::EndArray() {
+		EndContainer_(false);
+		return *this;
+	}
+
+	Writer& Writer::StartDict() {
+		BeforeValue_();
+		PrintOpening('{', MakePrintContext(output_, containers_.size(), format_));
+		containers_.push_back({ true });
+		return *this;
+	}
+
+	Writer& Writer::EndDict() {
+		EndContainer_(true);
+		return *this;
+	}
+
+	Writer& Writer::Key(std::string_view key) {
+		if (containers_.empty() || !containers_.back().is_dict || is_after_key_) {
+			throw std::logic_error("Key was called not on Dict"s);
+		}
+		const PrintContext ctx = MakePrintContext(output_, containers_.size(), format_);
+		Container& container = containers_.back();
+		if (!container.is_empty) {
+			PrintSeparator(ctx);
+		}
+		container.is_empty = false;
+		ctx.PrintIndent();
+		PrintString(key, output_);
+		PrintKeySeparator(ctx);
+		is_after_key_ = true;
+		return *this;
+	}
+
+	Writer& Writer::Value(const Node& value) {
+		BeforeValue_();
+		PrintNode(value, MakePrintContext(output_, containers_.size(), format_));
+		return *this;
+	}
+
+	void Writer::BeforeValue_() {
+		if (containers_.empty()) {
+			return;
+		}
+		Container& container = containers_.back();
+		if (container.is_dict) {
+			// В словаре значение пишется сразу за своим ключом
+			if (!is_after_key_) {
+				throw std::logic_error("Value was called in Dict without Key"s);
+			}
+			is_after_key_ = false;
+			return;
+		}
+		const PrintContext ctx = MakePrintContext(output_, containers_.size(), format_);
+		if (!container.is_empty) {
+			PrintSeparator(ctx);
+		}
+		container.is_empty = false;
+		ctx.PrintIndent();
+	}
+
+	void Writer::EndContainer_(bool is_dict) {
+		if (containers_.empty() || containers_.back().is_dict != is_dict || is_after_key_) {
+			throw std::logic_error(is_dict ? "EndDict was called not on Dict"s : "EndArray was called not on Array"s);
+		}
+		containers_.pop_back();
+		PrintClosing(is_dict ? '}' : ']', MakePrintContext(output_, containers_.size(), format_));
 	}
 
 }  // namespace json
\ No newline at end of file
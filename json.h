@@ -1,17 +1,62 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
-#include <map>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
 namespace json {
 
 	class Node;
-	using Dict = std::map<std::string, Node>;
 	using Array = std::vector<Node>;
 
+	// Словарь в виде массива пар, отсортированного по ключам: все пары лежат
+	// в одном блоке памяти, а не в отдельном узле дерева на каждый ключ.
+	// Интерфейс повторяет нужную часть std::map, порядок обхода тот же
+	class Dict {
+	public:
+		using value_type = std::pair<std::string, Node>;
+		using const_iterator = std::vector<value_type>::const_iterator;
+
+		Dict() = default;
+		// items должны быть отсортированы по ключам и не содержать повторов
+		explicit Dict(std::vector<value_type> items)
+			: items_(std::move(items)) {
+		}
+
+		const_iterator begin() const {
+			return items_.begin();
+		}
+		const_iterator end() const {
+			return items_.end();
+		}
+		size_t size() const {
+			return items_.size();
+		}
+		bool empty() const {
+			return items_.empty();
+		}
+
+		const_iterator find(std::string_view key) const;
+		size_t count(std::string_view key) const;
+		// Бросает std::out_of_range, если ключа нет
+		const Node& at(std::string_view key) const;
+		// Добавляет пустое значение, если ключа нет
+		Node& operator[](std::string key);
+
+		bool operator==(const Dict& rhs) const;
+
+	private:
+		std::vector<value_type> items_;
+
+		std::vector<value_type>::const_iterator LowerBound_(std::string_view key) const;
+	};
+
 	class ParsingError : public std::runtime_error {
 	public:
 		using runtime_error::runtime_error;
@@ -23,6 +68,13 @@ namespace json {
 		using variant::variant;
 		using Value = variant;
 
+		Node(Value&& value) {
+			std::visit([this](auto&& alternative) {
+				using Alternative = std::decay_t<decltype(alternative)>;
+				this->template emplace<Alternative>(std::move(alternative));
+			}, value);
+		}
+
 		Node(const Value& value) {
 			if (std::holds_alternative<int>(value)) {
 				this->emplace<int>(std::get<int>(value));
@@ -85,7 +137,7 @@ namespace json {
 		bool IsArray() const {
 			return std::holds_alternative<Array>(*this);
 		}
-		const Array& AsArray() const {
+		const Array& AsArray() const& {
 			using namespace std::literals;
 			if (!IsArray()) {
 				throw std::logic_error("Not an array"s);
@@ -93,11 +145,21 @@ namespace json {
 
 			return std::get<Array>(*this);
 		}
+		// Забирает значение из узла, который больше не нужен:
+		// std::move(node).AsArray()
+		Array AsArray() && {
+			using namespace std::literals;
+			if (!IsArray()) {
+				throw std::logic_error("Not an array"s);
+			}
+
+			return std::move(std::get<Array>(*this));
+		}
 
 		bool IsString() const {
 			return std::holds_alternative<std::string>(*this);
 		}
-		const std::string& AsString() const {
+		const std::string& AsString() const& {
 			using namespace std::literals;
 			if (!IsString()) {
 				throw std::logic_error("Not a string"s);
@@ -105,11 +167,21 @@ namespace json {
 
 			return std::get<std::string>(*this);
 		}
+		// Забирает значение из узла, который больше не нужен:
+		// std::move(node).AsString()
+		std::string AsString() && {
+			using namespace std::literals;
+			if (!IsString()) {
+				throw std::logic_error("Not a string"s);
+			}
+
+			return std::move(std::get<std::string>(*this));
+		}
 
 		bool IsDict() const {
 			return std::holds_alternative<Dict>(*this);
 		}
-		const Dict& AsDict() const {
+		const Dict& AsDict() const& {
 			using namespace std::literals;
 			if (!IsDict()) {
 				throw std::logic_error("Not a dict"s);
@@ -117,6 +189,16 @@ namespace json {
 
 			return std::get<Dict>(*this);
 		}
+		// Забирает значение из узла, который больше не нужен:
+		// std::move(node).AsDict()
+		Dict AsDict() && {
+			using namespace std::literals;
+			if (!IsDict()) {
+				throw std::logic_error("Not a dict"s);
+			}
+
+			return std::move(std::get<Dict>(*this));
+		}
 
 		bool operator==(const Node& rhs) const {
 			return GetValue() == rhs.GetValue();
@@ -131,15 +213,54 @@ namespace json {
 		return !(lhs == rhs);
 	}
 
+	inline std::vector<Dict::value_type>::const_iterator Dict::LowerBound_(std::string_view key) const {
+		return std::lower_bound(items_.begin(), items_.end(), key, [](const value_type& item, std::string_view key) {
+			return std::string_view(item.first) < key;
+		});
+	}
+
+	inline Dict::const_iterator Dict::find(std::string_view key) const {
+		const auto it = LowerBound_(key);
+		return it != items_.end() && it->first == key ? it : items_.end();
+	}
+
+	inline size_t Dict::count(std::string_view key) const {
+		return find(key) == items_.end() ? 0 : 1;
+	}
+
+	inline const Node& Dict::at(std::string_view key) const {
+		const auto it = find(key);
+		if (it == items_.end()) {
+			throw std::out_of_range("Dict has no key '" + std::string(key) + "'");
+		}
+		return it->second;
+	}
+
+	inline Node& Dict::operator[](std::string key) {
+		const size_t index = LowerBound_(key) - items_.begin();
+		if (index == items_.size() || items_[index].first != key) {
+			items_.emplace(items_.begin() + index, std::move(key), Node{});
+		}
+		return items_[index].second;
+	}
+
+	inline bool Dict::operator==(const Dict& rhs) const {
+		return items_ == rhs.items_;
+	}
+
 	class Document {
 	public:
 		explicit Document(Node root)
 			: root_(std::move(root)) {
 		}
 
-		const Node& GetRoot() const {
+		const Node& GetRoot() const& {
 			return root_;
 		}
+		// Забирает дерево из временного документа: json::Load(input).GetRoot()
+		Node GetRoot() && {
+			return std::move(root_);
+		}
 
 	private:
 		Node root_;
@@ -153,8 +274,50 @@ namespace json {
 		return !(lhs == rhs);
 	}
 
+	// Разбор текста JSON, целиком лежащего в памяти
+	Document Load(std::string_view input);
+	// Читает поток до конца и разбирает прочитанное
 	Document Load(std::istream& input);
 
-	void Print(const Document& doc, std::ostream& output);
+	// PRETTY - с переводами строк и отступами в 4 пробела, COMPACT - в одну строку
+	enum class Format {
+		PRETTY,
+		COMPACT
+	};
+
+	void Print(const Document& doc, std::ostream& output, Format format = Format::PRETTY);
+
+	// Потоковая запись JSON в том же виде, что и Print. Значения пишутся
+	// в поток сразу, в памяти хранятся только открытые массивы и словари.
+	// Ключи словаря пишутся в порядке вызовов, а не отсортированными
+	class Writer {
+	public:
+		explicit Writer(std::ostream& output, Format format = Format::PRETTY)
+			: output_(output)
+			, format_(format) {
+		}
+
+		Writer& StartArray();
+		Writer& EndArray();
+		Writer& StartDict();
+		Writer& EndDict();
+		Writer& Key(std::string_view key);
+		Writer& Value(const Node& value);
+
+	private:
+		struct Container {
+			bool is_dict = false;
+			bool is_empty = true;
+		};
+
+		std::ostream& output_;
+		Format format_;
+		std::vector<Container> containers_;
+		bool is_after_key_ = false;
+
+		// Разделитель и отступ перед очередным значением
+		void BeforeValue_();
+		void EndContainer_(bool is_dict);
+	};
 
 }  // namespace json
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "json_builder.h"
 
+#include <algorithm>
+
 namespace json {
 
 	AfterKey Builder::Key(std::string&& key) {
@@ -54,7 +56,7 @@ namespace json {
 		ErrorsChecker errors_checher(*this, end_dict_func_name_);
 
 		size_t unfinished_nodes_size = unfinished_nodes_.size();
-		Dict dict_to_push = std::get<Dict>(unfinished_nodes_.back());
+		Dict dict_to_push = std::move(std::get<Dict>(unfinished_nodes_.back()));
 		if (unfinished_nodes_size < 2) {
 			// Создать результирующий узел
 			root_ = std::move(dict_to_push);
@@ -82,7 +84,7 @@ namespace json {
 		ErrorsChecker errors_checher(*this, end_array_func_name_);
 
 		size_t unfinished_nodes_size = unfinished_nodes_.size();
-		Array array_to_push = std::get<Array>(unfinished_nodes_.back());
+		Array array_to_push = std::move(std::get<Array>(unfinished_nodes_.back()));
 		if (unfinished_nodes_size < 2) {
 			// Создать результирующий узел
 			root_ = std::move(array_to_push);
@@ -257,4 +259,79 @@ namespace json {
 		return GetBuilder();
 	}
 
-}
\ No newline at end of file
+	// ==================  NodeTarget  ==================
+
+	void NodeTarget::StartArray() {
+		unfinished_nodes_.push_back(Array());
+	}
+
+	void NodeTarget::EndArray() {
+		using namespace std::literals;
+
+		if (unfinished_nodes_.empty() || !std::holds_alternative<Array>(unfinished_nodes_.back())) {
+			throw std::logic_error("EndArray was called not on Array"s);
+		}
+		Array array = std::move(std::get<Array>(unfinished_nodes_.back()));
+		unfinished_nodes_.pop_back();
+		Add_(std::move(array));
+	}
+
+	void NodeTarget::StartDict() {
+		unfinished_nodes_.push_back(DictItems());
+	}
+
+	void NodeTarget::EndDict() {
+		using namespace std::literals;
+
+		if (unfinished_nodes_.empty() || !std::holds_alternative<DictItems>(unfinished_nodes_.back())) {
+			throw std::logic_error("EndDict was called not on Dict"s);
+		}
+		DictItems items = std::move(std::get<DictItems>(unfinished_nodes_.back()));
+		unfinished_nodes_.pop_back();
+		// Ключи обычно уже идут по возрастанию, тогда сортировка ничего не переставляет
+		std::stable_sort(items.begin(), items.end(), [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+			return lhs.first < rhs.first;
+		});
+		const auto duplicate = std::adjacent_find(items.begin(), items.end(),
+			[](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+				return lhs.first == rhs.first;
+			});
+		if (duplicate != items.end()) {
+			throw std::logic_error("Duplicate key '"s + duplicate->first + "' in Dict"s);
+		}
+		Add_(Dict(std::move(items)));
+	}
+
+	void NodeTarget::Key(std::string_view key) {
+		using namespace std::literals;
+
+		if (unfinished_nodes_.empty() || !std::holds_alternative<DictItems>(unfinished_nodes_.back())) {
+			throw std::logic_error("Key was called not on Dict"s);
+		}
+		// Значение появится следующим вызовом
+		std::get<DictItems>(unfinished_nodes_.back()).emplace_back(std::string(key), Node());
+	}
+
+	void NodeTarget::Value(Node value) {
+		Add_(std::move(value));
+	}
+
+	Node NodeTarget::Build() {
+		return std::move(root_);
+	}
+
+	void NodeTarget::Add_(Node node) {
+		if (unfinished_nodes_.empty()) {
+			root_ = std::move(node);
+		} else if (Array* array = std::get_if<Array>(&unfinished_nodes_.back())) {
+			array->push_back(std::move(node));
+		} else {
+			DictItems& items = std::get<DictItems>(unfinished_nodes_.back());
+			if (items.empty()) {
+				throw std::logic_error("Value was called in Dict without Key");
+			}
+			items.back().second = std::move(node);
+		}
+	}
+
+}
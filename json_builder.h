@@ -3,6 +3,9 @@
 #include <vector>
 #include <string>
 #include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <variant>
 
 #include "json.h"
 
@@ -189,4 +192,173 @@ namespace json {
 		json::Node Build() = delete;
 	};
 
-}
\ No newline at end of file
+	// ==================  Типизированный построитель  ==================
+	//
+	// Порядок вызовов проверяется при компиляции: каждый вызов возвращает
+	// объект-состояние, у которого есть только допустимые дальше методы,
+	// а закрытие массива или словаря возвращает состояние того, кто его
+	// открыл. Состояния хранят лишь ссылку на цель и ничего не проверяют
+	// во время работы. Методы состояний вызываются только у временных
+	// объектов (&&), так что одно состояние не продолжить дважды; чтобы
+	// передать его в функцию, его передают по значению.
+	//
+	// Цель (Target) получает события StartArray, EndArray, StartDict, EndDict,
+	// Key(std::string_view) и Value(Node). Это NodeTarget, который собирает
+	// дерево Node, или json::Writer, который сразу пишет в поток. Writer
+	// выводит ключи в порядке вызовов, поэтому для вывода как у Print
+	// ключи нужно передавать по возрастанию.
+	//
+	// Один построитель описывает одно значение, которое цель принимает
+	// в своем текущем месте - например, очередной элемент уже открытого
+	// массива: json::TypedBuilder(target).StartDict()...EndDict()
+
+	// Цель, которая собирает дерево Node
+	class NodeTarget {
+	public:
+		void StartArray();
+		void EndArray();
+		void StartDict();
+		void EndDict();
+		void Key(std::string_view key);
+		void Value(Node value);
+
+		// Забирает построенное значение
+		Node Build();
+
+	private:
+		// Пары словаря копятся подряд и сортируются при его закрытии
+		using DictItems = std::vector<Dict::value_type>;
+
+		Node root_;
+		std::vector<std::variant<Array, DictItems>> unfinished_nodes_;
+
+		void Add_(Node node);
+	};
+
+	template <typename Target>
+	class TypedBuilderDone;
+	template <typename Target, typename Parent>
+	class TypedArrayContext;
+	template <typename Target, typename Parent>
+	class TypedDictContext;
+	template <typename Target, typename Parent>
+	class TypedKeyContext;
+
+	// Начало построения значения
+	template <typename Target>
+	class TypedBuilder {
+	public:
+		explicit TypedBuilder(Target& target)
+			: target_(target) {
+		}
+
+		TypedBuilderDone<Target> Value(Node value) && {
+			target_.Value(std::move(value));
+			return TypedBuilderDone<Target>(target_);
+		}
+		TypedArrayContext<Target, TypedBuilderDone<Target>> StartArray() && {
+			target_.StartArray();
+			return TypedArrayContext<Target, TypedBuilderDone<Target>>(target_);
+		}
+		TypedDictContext<Target, TypedBuilderDone<Target>> StartDict() && {
+			target_.StartDict();
+			return TypedDictContext<Target, TypedBuilderDone<Target>>(target_);
+		}
+
+	private:
+		Target& target_;
+	};
+
+	// Значение построено целиком
+	template <typename Target>
+	class TypedBuilderDone {
+	public:
+		explicit TypedBuilderDone(Target& target)
+			: target_(target) {
+		}
+
+		// Есть только у целей, которые собирают значение (NodeTarget)
+		Node Build() && {
+			return target_.Build();
+		}
+
+	private:
+		Target& target_;
+	};
+
+	// Внутри массива: Value, StartArray, StartDict или EndArray
+	template <typename Target, typename Parent>
+	class TypedArrayContext {
+	public:
+		explicit TypedArrayContext(Target& target)
+			: target_(target) {
+		}
+
+		TypedArrayContext Value(Node value) && {
+			target_.Value(std::move(value));
+			return TypedArrayContext(target_);
+		}
+		TypedArrayContext<Target, TypedArrayContext> StartArray() && {
+			target_.StartArray();
+			return TypedArrayContext<Target, TypedArrayContext>(target_);
+		}
+		TypedDictContext<Target, TypedArrayContext> StartDict() && {
+			target_.StartDict();
+			return TypedDictContext<Target, TypedArrayContext>(target_);
+		}
+		Parent EndArray() && {
+			target_.EndArray();
+			return Parent(target_);
+		}
+
+	private:
+		Target& target_;
+	};
+
+	// Внутри словаря между парами: Key или EndDict
+	template <typename Target, typename Parent>
+	class TypedDictContext {
+	public:
+		explicit TypedDictContext(Target& target)
+			: target_(target) {
+		}
+
+		TypedKeyContext<Target, Parent> Key(std::string_view key) && {
+			target_.Key(key);
+			return TypedKeyContext<Target, Parent>(target_);
+		}
+		Parent EndDict() && {
+			target_.EndDict();
+			return Parent(target_);
+		}
+
+	private:
+		Target& target_;
+	};
+
+	// После Key: значение по этому ключу
+	template <typename Target, typename Parent>
+	class TypedKeyContext {
+	public:
+		explicit TypedKeyContext(Target& target)
+			: target_(target) {
+		}
+
+		TypedDictContext<Target, Parent> Value(Node value) && {
+			target_.Value(std::move(value));
+			return TypedDictContext<Target, Parent>(target_);
+		}
+		TypedArrayContext<Target, TypedDictContext<Target, Parent>> StartArray() && {
+			target_.StartArray();
+			return TypedArrayContext<Target, TypedDictContext<Target, Parent>>(target_);
+		}
+		TypedDictContext<Target, TypedDictContext<Target, Parent>> StartDict() && {
+			target_.StartDict();
+			return TypedDictContext<Target, TypedDictContext<Target, Parent>>(target_);
+		}
+
+	private:
+		Target& target_;
+	};
+
+}
@@ -1,62 +1,50 @@
 #include "json_reader.h"
 
-// Переводит информацию об остановке в JSON документе
-// в строку
-std::string CreateAddStopQuery(const json::Dict& dict) {
+// Обновляет каталог запросами из JSON в три прохода: сначала все
+// остановки, затем все маршруты, затем расстояния между остановками.
+// Встречные расстояния, заданные явно, хранятся оба
+void UpdateCatalog(TransportCatalogue& transoprt_catalogue, const json::Array& arr) {
 	using namespace std::literals;
 
-	std::string result_query = StopRequest + " "s + dict.at("name"s).AsString() + ": "s +
-		DoubleToString(dict.at("latitude"s).AsDouble()) + ",_"s +
-		DoubleToString(dict.at("longitude"s).AsDouble());
-
-	// Информации о расстоянии до ближайших
-	// остановок может не быть
-	try {
-		json::Dict distances = dict.at("road_distances"s).AsDict();
-
-		for (const auto& [stop_name, distance] : distances) {
-			result_query += ",_"s + DoubleToString(distance.AsDouble()) + "m to "s + stop_name;
+	std::vector<const json::Dict*> stops_requests;
+	std::vector<const json::Dict*> buses_requests;
+	for (const json::Node& node : arr) {
+		const json::Dict& dict = node.AsDict();
+		if (dict.at("type"s).AsString() == BusRequest) {
+			buses_requests.push_back(&dict);
+		} else if (dict.at("type"s).AsString() == StopRequest) {
+			stops_requests.push_back(&dict);
 		}
-	} catch (std::out_of_range&) {}
-
-	return result_query;
-}
-
-// Переводит информацию об маршруте в JSON документе
-// в строку
-std::string CreateAddBusQuery(const json::Dict& dict) {
-	using namespace std::literals;
-
-	std::string is_roundtrip_separator = " > "s;
-	std::string not_roundtrip_separator = " - "s;
+	}
 
-	std::string result_query = BusRequest + " "s + dict.at("name"s).AsString() + ": "s;
-	bool is_roundtrip = dict.at("is_roundtrip"s).AsBool();
+	for (const json::Dict* dict : stops_requests) {
+		transoprt_catalogue.AddStop(dict->at("name"s).AsString(),
+			{ dict->at("latitude"s).AsDouble(), dict->at("longitude"s).AsDouble() });
+	}
 
-	json::Array bus_stops = dict.at("stops"s).AsArray();
-	for (size_t i = 0; i < bus_stops.size(); ++i) {
-		result_query += bus_stops.at(i).AsString();
-		// Чтоб не ставить сепаратор после последнего элемента
-		if (i != bus_stops.size() - 1) {
-			result_query += (is_roundtrip) ? is_roundtrip_separator : not_roundtrip_separator;
+	std::vector<std::string> stop_names;
+	for (const json::Dict* dict : buses_requests) {
+		stop_names.clear();
+		for (const json::Node& stop_name : dict->at("stops"s).AsArray()) {
+			stop_names.push_back(stop_name.AsString());
 		}
+		transoprt_catalogue.AddBus(dict->at("name"s).AsString(), stop_names, dict->at("is_roundtrip"s).AsBool());
 	}
 
-	return result_query;
-}
-
-// Переводит запросы на обновление транспортного каталога из JSON в 
-// std::istringstream и обновляет каталог
-void UpdateCatalog(TransportCatalogue& transoprt_catalogue, const json::Array& arr) {
-	for (const json::Node& node : arr) {
-		const json::Dict dict = node.AsDict();
-		if (dict.at("type").AsString() == BusRequest) {
-			std::istringstream strm(CreateAddBusQuery(dict));
-			ParseInputQuery(transoprt_catalogue, strm);
-		} else if (dict.at("type").AsString() == StopRequest) {
-			std::istringstream strm(CreateAddStopQuery(dict));
-			ParseInputQuery(transoprt_catalogue, strm);
+	std::vector<std::pair<std::string, int>> distances;
+	for (const json::Dict* dict : stops_requests) {
+		// Информации о расстоянии до ближайших
+		// остановок может не быть
+		auto it = dict->find("road_distances"s);
+		if (it == dict->end()) {
+			continue;
+		}
+		distances.clear();
+		for (const auto& [stop_name, distance] : it->second.AsDict()) {
+			// Расстояния целые, дробная часть отбрасывается
+			distances.push_back({ stop_name, static_cast<int>(distance.AsDouble()) });
 		}
+		transoprt_catalogue.AddDistances(dict->at("name"s).AsString(), distances);
 	}
 }
 
@@ -80,11 +68,11 @@ RenderSettings GetRenderSettings(const json::Dict& dict) {
 	render_settings.stop_label_offset[0] = dict.at("stop_label_offset"s).AsArray().at(0).AsDouble();
 	render_settings.stop_label_offset[1] = dict.at("stop_label_offset"s).AsArray().at(1).AsDouble();
 
-	json::Node color_node = dict.at("underlayer_color"s);
+	const json::Node& color_node = dict.at("underlayer_color"s);
 	if (color_node.IsString()) {
 		render_settings.underlayer_color = color_node.AsString();
 	} else if (color_node.IsArray()) {
-		json::Array color_array = color_node.AsArray();
+		const json::Array& color_array = color_node.AsArray();
 		if (color_array.size() == 3) {
 			render_settings.underlayer_color = svg::Rgb(color_array.at(0).AsInt(), color_array.at(1).AsInt(), color_array.at(2).AsInt());
 		} else if (color_array.size() == 4) {
@@ -94,15 +82,15 @@ RenderSettings GetRenderSettings(const json::Dict& dict) {
 
 	render_settings.underlayer_width = dict.at("underlayer_width"s).AsDouble();
 
-	json::Array colors = dict.at("color_palette"s).AsArray();
+	const json::Array& colors = dict.at("color_palette"s).AsArray();
 	render_settings.color_palette.clear();
 	for (size_t i = 0; i < colors.size(); ++i) {
-		json::Node color = colors.at(i);
+		const json::Node& color = colors.at(i);
 		if (color.IsString()) {
 			render_settings.color_palette.push_back(color.AsString());
 			continue;
 		}
-		json::Array color_array = color.AsArray();
+		const json::Array& color_array = color.AsArray();
 		if (color_array.size() == 3) {
 			render_settings.color_palette.push_back(svg::Rgb(color_array.at(0).AsInt(), color_array.at(1).AsInt(), color_array.at(2).AsInt()));
 		} else if (color_array.size() == 4) {
@@ -120,46 +108,152 @@ RouteSettings GetRouteSettings(const json::Dict& dict) {
 	route_settings.bus_wait_time = dict.at("bus_wait_time"s).AsInt();
 	route_settings.bus_velocity = dict.at("bus_velocity"s).AsDouble() * 50.0 / 3.0; // перевод из км/ч в м/мин
 
+	// Необязательные настройки движка маршрутизации
+	if (dict.count("router_type"s)) {
+		const std::string& router_type = dict.at("router_type"s).AsString();
+		if (router_type == "all_pairs"s) {
+			route_settings.router_type = RouterType::ALL_PAIRS;
+		} else if (router_type == "dijkstra"s) {
+			route_settings.router_type = RouterType::DIJKSTRA;
+		} else if (router_type == "lazy_rows"s) {
+			route_settings.router_type = RouterType::LAZY_ROWS;
+		} else {
+			throw std::invalid_argument("Unknown router_type: "s + router_type);
+		}
+	}
+	if (dict.count("route_cache_size"s)) {
+		route_settings.route_cache_size = dict.at("route_cache_size"s).AsInt();
+	}
+	if (dict.count("route_rows_limit"s)) {
+		route_settings.route_rows_limit = dict.at("route_rows_limit"s).AsInt();
+	}
+	if (dict.count("graph_model"s)) {
+		const std::string& graph_model = dict.at("graph_model"s).AsString();
+		if (graph_model == "bus_spans"s) {
+			route_settings.graph_model = GraphModel::BUS_SPANS;
+		} else if (graph_model == "stop_and_wait"s) {
+			route_settings.graph_model = GraphModel::STOP_AND_WAIT;
+		} else {
+			throw std::invalid_argument("Unknown graph_model: "s + graph_model);
+		}
+	}
+
 	return route_settings;
 }
 
 SerializationSettings GetSerializationSettings(const json::Dict& dict){
+	using namespace std::literals;
+
 	SerializationSettings serialization_settings;
 
 	serialization_settings.file_name = Path(dict.at("file").AsString());
+	if (dict.count("format"s)) {
+		const std::string& format = dict.at("format"s).AsString();
+		if (format == "protobuf"s) {
+			serialization_settings.format = BaseFormat::PROTOBUF;
+		} else if (format == "mapped"s) {
+			serialization_settings.format = BaseFormat::MAPPED;
+		} else {
+			throw std::invalid_argument("Unknown base format: "s + format);
+		}
+	}
+	if (dict.count("router_encoding"s)) {
+		const std::string& router_encoding = dict.at("router_encoding"s).AsString();
+		if (router_encoding == "raw"s) {
+			serialization_settings.router_encoding = RouterEncoding::RAW;
+		} else if (router_encoding == "sparse"s) {
+			serialization_settings.router_encoding = RouterEncoding::SPARSE;
+		} else if (router_encoding == "sparse_gzip"s) {
+			serialization_settings.router_encoding = RouterEncoding::SPARSE_GZIP;
+		} else {
+			throw std::invalid_argument("Unknown router_encoding: "s + router_encoding);
+		}
+	}
 
 	return serialization_settings;
 }
 
+BaseSections GetRequiredBaseSections(const json::Array& requests_array){
+	using namespace std::literals;
+
+	BaseSections sections;
+	sections.render_settings = false;
+	sections.routing = false;
+	for (const json::Node& request : requests_array) {
+		const std::string& type = request.AsDict().at("type"s).AsString();
+		if (type == MapRequest) {
+			sections.render_settings = true;
+		} else if (type == RouteRequest) {
+			sections.routing = true;
+		}
+	}
+
+	return sections;
+}
+
 std::string FindStopName(TransportCatalogue& transoprt_catalogue, size_t index) {
-	auto& stops = transoprt_catalogue.GetStops();
+	if (index >= transoprt_catalogue.GetStopsCount()) {
+		return "";
+	}
+	return transoprt_catalogue.GetStop(index).name;
+}
+
+// Заранее отвечает на запросы Route, обходя их в порядке, сгруппированном
+// по остановке отправления: так движок LAZY_ROWS строит каждую строку
+// кратчайших путей один раз за пакет даже при ограниченном числе строк.
+// Ответ на i-й запрос лежит в i-й ячейке, для остальных запросов - null
+std::vector<json::Node> AnswerRouteRequestsGroupedByFrom(TransportManagers& transport_managers, const json::Array& requests_array) {
+	using namespace std::literals;
 
-	for (const auto stop : stops) {
-		if (stop.second.get()->id == index) {
-			return stop.second.get()->name;
+	std::vector<size_t> route_requests;
+	for (size_t i = 0; i < requests_array.size(); ++i) {
+		if (requests_array.at(i).AsDict().at("type"s).AsString() == RouteRequest) {
+			route_requests.push_back(i);
 		}
 	}
-	return "";
+	std::stable_sort(route_requests.begin(), route_requests.end(), [&requests_array](size_t lhs, size_t rhs) {
+		return requests_array.at(lhs).AsDict().at("from"s).AsString() < requests_array.at(rhs).AsDict().at("from"s).AsString();
+	});
+
+	std::vector<json::Node> answers(requests_array.size());
+	for (size_t i : route_requests) {
+		const json::Dict& current_request = requests_array.at(i).AsDict();
+		json::NodeTarget target;
+		transport_managers.transport_router.ParseQuery(current_request.at("from"s).AsString(),
+			current_request.at("to"s).AsString(), current_request.at("id"s).AsInt(), target);
+		answers[i] = target.Build();
+	}
+
+	return answers;
 }
 
-void PrintCatatlog(TransportManagers& transport_managers, const json::Array& requests_array, std::ostream& output_stream) {
+void PrintCatatlog(TransportManagers& transport_managers, const json::Array& requests_array, std::ostream& output_stream,
+	json::Format output_format) {
 	using namespace std::literals;
 
-	transport_managers.transport_router.SetHash();
+	std::vector<json::Node> route_answers;
+	if (transport_managers.transport_router.GetRouteSettings().router_type == RouterType::LAZY_ROWS) {
+		route_answers = AnswerRouteRequestsGroupedByFrom(transport_managers, requests_array);
+	}
 
-	json::Builder json_builder;
-	json_builder.StartArray();
+	// Ответы пишутся в поток по одному, сразу после расчета:
+	// в памяти никогда не бывает ответов на весь пакет
+	json::Writer writer(output_stream, output_format);
+	writer.StartArray();
 	for (size_t i = 0; i < requests_array.size(); ++i) {
-		const json::Dict current_request = requests_array.at(i).AsDict();
+		const json::Dict& current_request = requests_array.at(i).AsDict();
 
 		int request_id = current_request.at("id"s).AsInt();
 		std::string type = current_request.at("type"s).AsString();
 
+		// Ключи ответов передаются по возрастанию, как их выводит json::Print
 		if (type == MapRequest) {  // запрос на рисовку карты
 			std::ostringstream tmp_output_stream;
 			transport_managers.map_renderer.RenderMapAsString(tmp_output_stream);
-			json_builder.StartDict().Key("request_id").Value(request_id)
-				.Key("map"s).Value(tmp_output_stream.str()).EndDict();
+			json::TypedBuilder(writer).StartDict()
+				.Key("map"sv).Value(tmp_output_stream.str())
+				.Key("request_id"sv).Value(request_id)
+				.EndDict();
 		} else if (type == BusRequest || type == StopRequest) {  //запрос на информацию об остановке или маршруте
 			std::string name = current_request.at("name"s).AsString();
 			std::vector<std::pair<std::string, json::Node>> tmp_vector;
@@ -168,43 +262,53 @@ void PrintCatatlog(TransportManagers& transport_managers, const json::Array& req
 			// Просим у транспортного каталога записать информацию о запросе в вектор tmp_vector
 			ParseOutputQuery(transport_managers.transoprt_catalogue, tmp_vector, query_input_str_stream);
 
-			json_builder.StartDict()
-				.Key("request_id"s).Value(request_id);
 			if (tmp_vector.size() == 0) { // Когда нет автобусов для текущей остановки
-				json_builder.Key("buses"s).StartArray().EndArray();
+				json::TypedBuilder(writer).StartDict()
+					.Key("buses"sv).StartArray().EndArray()
+					.Key("request_id"sv).Value(request_id)
+					.EndDict();
 			} else if (tmp_vector.front().first == "error_message") { // Если нет информации об остановке или маршруте
-				json_builder.Key("error_message"s).Value("not found"s);
+				json::TypedBuilder(writer).StartDict()
+					.Key("error_message"sv).Value("not found"s)
+					.Key("request_id"sv).Value(request_id)
+					.EndDict();
 			} else if (type == BusRequest) { // Вывод информации о маршруте
-				json_builder
-					.Key(std::move(tmp_vector.at(0).first)).Value(tmp_vector.at(0).second.AsDouble())
-					.Key(std::move(tmp_vector.at(1).first)).Value(tmp_vector.at(1).second.AsDouble())
-					.Key(std::move(tmp_vector.at(2).first)).Value(tmp_vector.at(2).second.AsInt())
-					.Key(std::move(tmp_vector.at(3).first)).Value(tmp_vector.at(3).second.AsInt());
+				// curvature, route_length, stop_count, unique_stop_count
+				json::TypedBuilder(writer).StartDict()
+					.Key(tmp_vector.at(0).first).Value(tmp_vector.at(0).second.AsDouble())
+					.Key("request_id"sv).Value(request_id)
+					.Key(tmp_vector.at(1).first).Value(tmp_vector.at(1).second.AsDouble())
+					.Key(tmp_vector.at(2).first).Value(tmp_vector.at(2).second.AsInt())
+					.Key(tmp_vector.at(3).first).Value(tmp_vector.at(3).second.AsInt())
+					.EndDict();
 			} else if (type == StopRequest) { // Вывод информации об остановке
-				json_builder.Key("buses").StartArray();
-				for (size_t i = 0; i < tmp_vector.size(); ++i) {
-					json_builder.Value(tmp_vector.at(i).second.AsString());
+				// Названия маршрутов в tmp_vector уже лежат в узлах-строках
+				json::Array buses;
+				buses.reserve(tmp_vector.size());
+				for (auto& [key, bus_name] : tmp_vector) {
+					buses.push_back(std::move(bus_name));
 				}
-				json_builder.EndArray();
+				json::TypedBuilder(writer).StartDict()
+					.Key("buses"sv).Value(std::move(buses))
+					.Key("request_id"sv).Value(request_id)
+					.EndDict();
 			}
-			json_builder.EndDict();
+		} else if (type == RouteRequest && !route_answers.empty()) { // ответ на маршрут уже посчитан
+			writer.Value(route_answers.at(i));
 		} else if (type == RouteRequest) { // запрос на построение маршрута
-			const auto& stops = transport_managers.transoprt_catalogue.GetStops();
 			std::string stop_from = current_request.at("from"s).AsString();
 			std::string stop_to = current_request.at("to"s).AsString();
-			transport_managers.transport_router.ParseQuery(stop_from, stop_to, request_id, json_builder);
+			transport_managers.transport_router.ParseQuery(stop_from, stop_to, request_id, writer);
 		}
 	}
-
-	json::Document result_document(json_builder.EndArray().Build());
-	json::Print(result_document, output_stream);
+	writer.EndArray();
 }
 
-void ReadJSON(TransportManagers& transport_managers, std::istream& input_stream, std::ostream& output_stream) {
+void ReadJSON(TransportManagers& transport_managers, std::istream& input_stream) {
 	using namespace std::literals;
 
-	json::Document input_document = json::Load(input_stream);
-	json::Dict dict = input_document.GetRoot().AsDict();
+	// Дерево запросов забирается из документа без копирования
+	const json::Dict dict = json::Load(input_stream).GetRoot().AsDict();
 
 	if (dict.count("base_requests"))
 		UpdateCatalog(transport_managers.transoprt_catalogue, dict.at("base_requests"s).AsArray());
@@ -215,5 +319,9 @@ void ReadJSON(TransportManagers& transport_managers, std::istream& input_stream,
 	if (dict.count("serialization_settings"))
 		transport_managers.serialization.SetSerializationSettings(GetSerializationSettings(dict.at("serialization_settings").AsDict()));
 
+	// Статистика маршрутов пишется только в Bus::stats, а граф строится
+	// по остановкам маршрутов, поэтому их можно считать одновременно
+	auto stats_future = std::async(std::launch::async, SetBusesStats, std::ref(transport_managers.transoprt_catalogue));
 	transport_managers.transport_router.SetGraph();
+	stats_future.get();
 }
\ No newline at end of file
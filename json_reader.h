@@ -5,6 +5,8 @@
 #include <sstream>
 #include <vector>
 #include <utility>
+#include <future>
+#include <functional>
 
 #include "map_renderer.h"
 #include "request_handler.h"
@@ -28,10 +30,6 @@ struct TransportManagers {
 	Serialization& serialization;
 };
 
-std::string CreateAddStopQuery(const json::Dict& dict);
-
-std::string CreateAddBusQuery(const json::Dict& dict);
-
 void UpdateCatalog(TransportCatalogue& transoprt_catalogue, const json::Array& arr);
 
 RenderSettings GetRenderSettings(const json::Dict& dict);
@@ -40,6 +38,12 @@ RouteSettings GetRouteSettings(const json::Dict& dict);
 
 SerializationSettings GetSerializationSettings(const json::Dict& dict);
 
-void PrintCatatlog(TransportManagers& transport_managers, const json::Array& requests_array, std::ostream& output_stream);
+// Части базы, без которых не ответить на запросы requests_array
+BaseSections GetRequiredBaseSections(const json::Array& requests_array);
+
+std::vector<json::Node> AnswerRouteRequestsGroupedByFrom(TransportManagers& transport_managers, const json::Array& requests_array);
+
+void PrintCatatlog(TransportManagers& transport_managers, const json::Array& requests_array, std::ostream& output_stream,
+	json::Format output_format = json::Format::PRETTY);
 
-void ReadJSON(TransportManagers& transport_managers, std::istream& input_stream = std::cin, std::ostream& output_stream = std::cout);
\ No newline at end of file
+void ReadJSON(TransportManagers& transport_managers, std::istream& input_stream = std::cin);
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include <vector>
 #include <fstream>
 #include <optional>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
 
 #include "map_renderer.h"
 #include "json_reader.h"
@@ -10,15 +13,78 @@
 #include "transport_router.h"
 #include "serialization.h"
 #include "svg.h"
+#include "server.h"
 
 using namespace std;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-	stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+	stream << "Usage: transport_catalogue [make_base [--threads N]|process_requests [--compact]|\n"sv
+		<< "    serve --base FILE [--socket PATH] [--length-prefixed] [--compact]]\n"sv;
+}
+
+// Разбор параметра --threads N. По умолчанию используются все ядра
+optional<size_t> ParseThreadsCount(int argc, char* argv[]) {
+	size_t threads_count = max(1u, thread::hardware_concurrency());
+	for (int i = 2; i < argc; ++i) {
+		if (argv[i] != "--threads"sv || i + 1 == argc) {
+			return nullopt;
+		}
+		try {
+			threads_count = stoul(argv[++i]);
+		} catch (...) {
+			return nullopt;
+		}
+		if (threads_count == 0) {
+			return nullopt;
+		}
+	}
+	return threads_count;
+}
+
+// Разбор параметра --compact: ответы выводятся в одну строку
+optional<json::Format> ParseOutputFormat(int argc, char* argv[]) {
+	json::Format format = json::Format::PRETTY;
+	for (int i = 2; i < argc; ++i) {
+		if (argv[i] != "--compact"sv) {
+			return nullopt;
+		}
+		format = json::Format::COMPACT;
+	}
+	return format;
+}
+
+struct ServeOptions {
+	Path base_file;
+	// Пустой путь - пакеты читаются из stdin, ответы пишутся в stdout
+	string socket_path;
+	ServerSettings settings;
+};
+
+// Разбор параметров режима serve
+optional<ServeOptions> ParseServeOptions(int argc, char* argv[]) {
+	ServeOptions options;
+	for (int i = 2; i < argc; ++i) {
+		const string_view argument(argv[i]);
+		if (argument == "--base"sv && i + 1 < argc) {
+			options.base_file = argv[++i];
+		} else if (argument == "--socket"sv && i + 1 < argc) {
+			options.socket_path = argv[++i];
+		} else if (argument == "--length-prefixed"sv) {
+			options.settings.framing = Framing::LENGTH_PREFIXED;
+		} else if (argument == "--compact"sv) {
+			options.settings.output_format = json::Format::COMPACT;
+		} else {
+			return nullopt;
+		}
+	}
+	if (options.base_file.empty()) {
+		return nullopt;
+	}
+	return options;
 }
 
 int main(int argc, char* argv[]) {
-	if (argc != 2) {
+	if (argc < 2) {
 		PrintUsage();
 		return 1;
 	}
@@ -34,17 +100,52 @@ int main(int argc, char* argv[]) {
 
 	if (mode == "make_base"sv) {
 
+		optional<size_t> threads_count = ParseThreadsCount(argc, argv);
+		if (!threads_count) {
+			PrintUsage();
+			return 1;
+		}
+		transport_router.SetThreadsCount(*threads_count);
+
 		ReadJSON(transport_managers);
 		serialization.Serialize(transport_catalogue, map_renderer, transport_router);
 		
 	} else if (mode == "process_requests"sv) {
 
-		json::Document input_document = json::Load(std::cin);
-		json::Dict dict = input_document.GetRoot().AsDict();
+		optional<json::Format> output_format = ParseOutputFormat(argc, argv);
+		if (!output_format) {
+			PrintUsage();
+			return 1;
+		}
+
+		const json::Dict dict = json::Load(std::cin).GetRoot().AsDict();
 
 		transport_managers.serialization.SetSerializationSettings(GetSerializationSettings(dict.at("serialization_settings").AsDict()));
+		const json::Array& stat_requests = dict.at("stat_requests").AsArray();
+		serialization.Deserialize(transport_catalogue, map_renderer, transport_router, GetRequiredBaseSections(stat_requests));
+		PrintCatatlog(transport_managers, stat_requests, std::cout, *output_format);
+
+	} else if (mode == "serve"sv) {
+
+		optional<ServeOptions> options = ParseServeOptions(argc, argv);
+		if (!options) {
+			PrintUsage();
+			return 1;
+		}
+		if (!filesystem::exists(options->base_file)) {
+			cerr << "Base file "sv << options->base_file << " does not exist\n"sv;
+			return 1;
+		}
+
+		// База загружается целиком один раз: заранее неизвестно,
+		// какие запросы придут в пакетах
+		serialization.SetSerializationSettings({ options->base_file });
 		serialization.Deserialize(transport_catalogue, map_renderer, transport_router);
-		PrintCatatlog(transport_managers, dict.at("stat_requests").AsArray(), std::cout);
+		if (options->socket_path.empty()) {
+			ServeBatches(transport_managers, cin, cout, options->settings);
+		} else {
+			ServeUnixSocket(transport_managers, options->socket_path, options->settings);
+		}
 
 	} else {
 		PrintUsage();
@@ -39,22 +39,21 @@ void MapRenderer::RenderMapAsJSON(std::ostream& output_stream) {
 }
 
 void MapRenderer::CreateSphereProjector_() {
-	const auto& buses = transport_catalogue_.GetBuses();
-	std::vector<geo::Coordinates> points_of_all_stops = GetAllGeoPoints_(buses);
+	std::vector<geo::Coordinates> points_of_all_stops = GetAllGeoPoints_();
 	sphere_projector_ = std::make_unique<SphereProjector>(points_of_all_stops.begin(), points_of_all_stops.end(), render_settings_.width, render_settings_.height, render_settings_.padding);
 }
 
 void MapRenderer::RenderBusesLines_() {
 	size_t color_palette_counter = 0;
 
-	// Метод transport_catalogue_.GetBuses() возвращает словарь
-	// std::map<std::string, std::shared_ptr<BUS>>, где строка - это название маршрута,
-	// а std::shared_ptr<BUS> - указатель на структуру маршрута
-	for (const auto& [bus_name, bus] : transport_catalogue_.GetBuses()) {
+	// Метод transport_catalogue_.GetBusesSortedByName() возвращает
+	// номера маршрутов в порядке их названий
+	for (BusId bus_id : transport_catalogue_.GetBusesSortedByName()) {
+		const Bus& bus = transport_catalogue_.GetBus(bus_id);
 		// Отрисовываем только непустые маршруты.
-		// Дек bus->stops хранит в себе указетели
-		// на остановки текущего маршрута
-		if (bus.get()->stops.size() == 0) {
+		// Вектор bus.stops хранит в себе номера
+		// остановок текущего маршрута
+		if (bus.stops.size() == 0) {
 			continue;
 		}
 		// Ломаная для текущего маршрута
@@ -90,30 +89,24 @@ void MapRenderer::RenderNamesOfBuses_() {
 
 	size_t color_palette_counter = 0;
 
-	// Метод transport_catalogue_.GetBuses() возвращает словарь
-	// std::map<std::string, std::shared_ptr<BUS>>, где строка - это название маршрута,
-	// а std::shared_ptr<BUS> - указатель на структуру маршрута
-	const auto& buses = transport_catalogue_.GetBuses();
-
-	for (const auto& [bus_name, bus] : buses) {
+	// Метод transport_catalogue_.GetBusesSortedByName() возвращает
+	// номера маршрутов в порядке их названий
+	for (BusId bus_id : transport_catalogue_.GetBusesSortedByName()) {
+		const Bus& bus = transport_catalogue_.GetBus(bus_id);
 		// Отрисовываем только непустые маршруты.
-		// Дек bus->stops хранит в себе указетели
-		// на остановки текущего маршрута
-		if (bus.get()->stops.size() == 0) {
+		// Вектор bus.stops хранит в себе номера
+		// остановок текущего маршрута
+		if (bus.stops.size() == 0) {
 			continue;
 		}
 
 		for (int i = 0; i < 2; ++i) {
-			std::shared_ptr<Stop> current_stop;
-			if (i == 0) { // итерация для начальной остановки
-				current_stop = bus.get()->stops.front();
-			} else { // для конечной некольцевого маршрута
-				current_stop = bus.get()->stops.at(bus.get()->stops.size() / 2);
-			}
+			// итерация для начальной остановки, затем для конечной некольцевого маршрута
+			const Stop& current_stop = transport_catalogue_.GetStop(i == 0 ? bus.stops.front() : bus.stops.at(bus.stops.size() / 2));
 
 			svg::Text stop_name, background;
-			stop_name.SetPosition((*sphere_projector_)({ current_stop.get()->coord_x, current_stop.get()->coord_y }));
-			background.SetPosition((*sphere_projector_)({ current_stop.get()->coord_x, current_stop.get()->coord_y }));
+			stop_name.SetPosition((*sphere_projector_)({ current_stop.coord_x, current_stop.coord_y }));
+			background.SetPosition((*sphere_projector_)({ current_stop.coord_x, current_stop.coord_y }));
 			stop_name.SetOffset({ render_settings_.bus_label_offset[0], render_settings_.bus_label_offset[1] });
 			background.SetOffset({ render_settings_.bus_label_offset[0], render_settings_.bus_label_offset[1] });
 			stop_name.SetFontSize(render_settings_.bus_label_font_size);
@@ -122,8 +115,8 @@ void MapRenderer::RenderNamesOfBuses_() {
 			background.SetFontFamily("Verdana"s);
 			stop_name.SetFontWeight("bold"s);
 			background.SetFontWeight("bold"s);
-			stop_name.SetData(bus.get()->name);
-			background.SetData(bus.get()->name);
+			stop_name.SetData(bus.name);
+			background.SetData(bus.name);
 
 			background.SetFillColor(render_settings_.underlayer_color);
 			background.SetStrokeColor(render_settings_.underlayer_color);
@@ -140,7 +133,7 @@ void MapRenderer::RenderNamesOfBuses_() {
 			// Если конечная и начальная остановки одинаковые, то выходим.
 			// Второе условие существует, потому что не кольцевой маршрут
 			// хранится так: A - B - C - B - A. Здесь C - конечная.
-			if (bus.get()->is_looped || bus.get()->stops.front() == bus.get()->stops.at(bus.get()->stops.size() / 2)) {
+			if (bus.is_looped || bus.stops.front() == bus.stops.at(bus.stops.size() / 2)) {
 				break;
 			}
 		}
@@ -155,27 +148,18 @@ void MapRenderer::RenderNamesOfBuses_() {
 }
 
 void MapRenderer::RenderStopsCircles_() {
-	// transport_catalogue_.GetStopsToBuses() вовзращает 
-	// словарь std::map<std::string, std::shared_ptr<std::set<std::string>>>,
-	// где ключ - это название маршрута, а значение - 
-	// указатель на сет названий маршуртов, которые проходят через эту остановку
-	const auto& stops_to_buses = transport_catalogue_.GetStopsToBuses();
-
-	// transport_catalogue_.GetStops() возвращает
-	// словарь std::map<std::string, std::shared_ptr<STOP>>.
-	// Здесь ключ - это название остановки, а значение - 
-	// указатель на нее
-	const auto& stops = transport_catalogue_.GetStops();
-
-	for (const auto& [stop_name, buses_set_ptr] : stops_to_buses) {
+	// transport_catalogue_.GetStopsSortedByName() возвращает
+	// номера остановок в порядке их названий
+
+	for (StopId stop_id : transport_catalogue_.GetStopsSortedByName()) {
+		const Stop& current_stop = transport_catalogue_.GetStop(stop_id);
 		// Отбрасываем остановки, через которые не ходят автобусы
-		if (buses_set_ptr.get()->size() == 0) {
+		if (current_stop.buses.empty()) {
 			continue;
 		}
 
-		std::shared_ptr<Stop> current_stop = stops.at(stop_name);
 		svg::Circle stop_circle;
-		stop_circle.SetCenter((*sphere_projector_)({ current_stop.get()->coord_x, current_stop.get()->coord_y }));
+		stop_circle.SetCenter((*sphere_projector_)({ current_stop.coord_x, current_stop.coord_y }));
 		stop_circle.SetRadius(render_settings_.stop_radius);
 		stop_circle.SetFillColor("white");
 
@@ -186,37 +170,28 @@ void MapRenderer::RenderStopsCircles_() {
 void MapRenderer::RenderNamesOfStops_() {
 	using namespace std::literals;
 
-	// transport_catalogue_.GetStopsToBuses() вовзращает 
-	// словарь std::map<std::string, std::shared_ptr<std::set<std::string>>>,
-	// где ключ - это название маршрута, а значение - 
-	// указатель на сет названий маршуртов, которые проходят через эту остановку
-	const auto& stops_to_buses = transport_catalogue_.GetStopsToBuses();
+	// transport_catalogue_.GetStopsSortedByName() возвращает
+	// номера остановок в порядке их названий
 
-	// transport_catalogue_.GetStops() возвращает
-	// словарь std::map<std::string, std::shared_ptr<STOP>>.
-	// Здесь ключ - это название остановки, а значение - 
-	// указатель на нее
-	const auto& stops = transport_catalogue_.GetStops();
-
-	for (const auto& [name_of_stop, buses_set_ptr] : stops_to_buses) {
+	for (StopId stop_id : transport_catalogue_.GetStopsSortedByName()) {
+		const Stop& current_stop = transport_catalogue_.GetStop(stop_id);
 		// Отбрасываем остановки, через которые не ходят автобусы
-		if (buses_set_ptr.get()->size() == 0) {
+		if (current_stop.buses.empty()) {
 			continue;
 		}
 
-		std::shared_ptr<Stop> current_stop = stops.at(name_of_stop);
 		svg::Text stop_name, background;
 
-		stop_name.SetPosition((*sphere_projector_)({ current_stop.get()->coord_x, current_stop.get()->coord_y }));
-		background.SetPosition((*sphere_projector_)({ current_stop.get()->coord_x, current_stop.get()->coord_y }));
+		stop_name.SetPosition((*sphere_projector_)({ current_stop.coord_x, current_stop.coord_y }));
+		background.SetPosition((*sphere_projector_)({ current_stop.coord_x, current_stop.coord_y }));
 		stop_name.SetOffset({ render_settings_.stop_label_offset[0], render_settings_.stop_label_offset[1] });
 		background.SetOffset({ render_settings_.stop_label_offset[0], render_settings_.stop_label_offset[1] });
 		stop_name.SetFontSize(render_settings_.stop_label_font_size);
 		background.SetFontSize(render_settings_.stop_label_font_size);
 		stop_name.SetFontFamily("Verdana"s);
 		background.SetFontFamily("Verdana"s);
-		stop_name.SetData(current_stop.get()->name);
-		background.SetData(current_stop.get()->name);
+		stop_name.SetData(current_stop.name);
+		background.SetData(current_stop.name);
 
 		background.SetFillColor(render_settings_.underlayer_color);
 		background.SetStrokeColor(render_settings_.underlayer_color);
@@ -232,11 +207,11 @@ void MapRenderer::RenderNamesOfStops_() {
 }
 
 // Возвращает вектор точек всех остановок по всем маршрутам, обработанных классом SphereProjector
-std::vector<geo::Coordinates> MapRenderer::GetAllGeoPoints_(const std::map<std::string, std::shared_ptr<Bus>>& buses) {
+std::vector<geo::Coordinates> MapRenderer::GetAllGeoPoints_() {
 	std::vector<geo::Coordinates> result_vector;
 
-	for (const auto& [name, bus_ptr] : buses) {
-		std::vector<geo::Coordinates> stop_points = GetGeoPointsOfBus_(bus_ptr);
+	for (const Bus& bus : transport_catalogue_.GetBuses()) {
+		std::vector<geo::Coordinates> stop_points = GetGeoPointsOfBus_(bus);
 		result_vector.insert(result_vector.end(), stop_points.begin(), stop_points.end());
 	}
 
@@ -244,17 +219,14 @@ std::vector<geo::Coordinates> MapRenderer::GetAllGeoPoints_(const std::map<std::
 }
 
 // Вовзращает вектор точек всех остановок, обработанных классом SphereProjector, по текущему маршруту
-std::vector<geo::Coordinates> MapRenderer::GetGeoPointsOfBus_(const std::shared_ptr<Bus> bus) {
+std::vector<geo::Coordinates> MapRenderer::GetGeoPointsOfBus_(const Bus& bus) {
 	std::vector<geo::Coordinates> result_vector;
-	std::deque<std::shared_ptr<Stop>>& stops = bus.get()->stops;
-	const auto& stops_to_buses = transport_catalogue_.GetStopsToBuses();
-
-	for (size_t i = 0; i < stops.size(); ++i) {
-		std::shared_ptr<Stop> stop = stops.at(i);
-		// Берем координаты остановок, по которым ходят автобусы
-		if (stops_to_buses.count(stop.get()->name) && stops_to_buses.at(stop.get()->name)->size() != 0) {
-			result_vector.push_back({ stop.get()->coord_x, stop.get()->coord_y });
-		}
+	result_vector.reserve(bus.stops.size());
+
+	for (StopId stop_id : bus.stops) {
+		// Остановки маршрута всегда обслуживаются хотя бы им самим
+		const Stop& stop = transport_catalogue_.GetStop(stop_id);
+		result_vector.push_back({ stop.coord_x, stop.coord_y });
 	}
 
 	return result_vector;
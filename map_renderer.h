@@ -123,8 +123,8 @@ private:
 	void RenderNamesOfStops_();
 
 	// Получает вектор всех точек остановок по всем маршрутам
-	std::vector<geo::Coordinates> GetAllGeoPoints_(const std::map<std::string, std::shared_ptr<Bus>>& buses);
+	std::vector<geo::Coordinates> GetAllGeoPoints_();
 
 	// Получает вектор точек остановок по текущему маршруту
-	std::vector<geo::Coordinates> GetGeoPointsOfBus_(const std::shared_ptr<Bus> bus);
+	std::vector<geo::Coordinates> GetGeoPointsOfBus_(const Bus& bus);
 };
\ No newline at end of file
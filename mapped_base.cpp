@@ -0,0 +1,64 @@
+#include "mapped_base.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mapped_base {
+
+	std::shared_ptr<MappedFile> MappedFile::Open(const std::filesystem::path& path) {
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			return nullptr;
+		}
+
+		struct stat file_stat;
+		if (::fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+			::close(fd);
+			return nullptr;
+		}
+
+		const std::size_t size = static_cast<std::size_t>(file_stat.st_size);
+		void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+		// Отображение остается действительным и после закрытия файла
+		::close(fd);
+		if (data == MAP_FAILED) {
+			return nullptr;
+		}
+
+		return std::shared_ptr<MappedFile>(new MappedFile(static_cast<const char*>(data), size));
+	}
+
+	MappedFile::~MappedFile() {
+		::munmap(const_cast<char*>(data_), size_);
+	}
+
+	bool MappedFile::HasMagic() const {
+		return size_ >= sizeof(Header) && std::memcmp(data_, MAGIC, sizeof(MAGIC)) == 0;
+	}
+
+	std::optional<Section> MappedFile::FindSection(SectionType type) const {
+		const Header& header = GetHeader();
+		if (sizeof(Header) + header.sections_count * sizeof(Section) > size_) {
+			return std::nullopt;
+		}
+
+		const Section* sections = reinterpret_cast<const Section*>(data_ + sizeof(Header));
+		for (std::uint32_t i = 0; i < header.sections_count; ++i) {
+			const Section& section = sections[i];
+			if (section.type != type) {
+				continue;
+			}
+			if (section.offset % ALIGNMENT != 0 || section.offset > size_ || section.size > size_ - section.offset) {
+				return std::nullopt;
+			}
+			return section;
+		}
+
+		return std::nullopt;
+	}
+
+}  // namespace mapped_base
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <optional>
+
+// Двоичный формат базы, который читается через отображение файла в память.
+// Файл начинается с заголовка и таблицы секций, за ними идут сами секции,
+// каждая выровнена на MAPPED_BASE_ALIGNMENT байт. Большие массивы (ребра
+// и списки инцидентности графа, матрица маршрутов) лежат в файле в том же
+// виде, что и в памяти, и используются на месте без копирования
+namespace mapped_base {
+
+	constexpr char MAGIC[8] = { 'T', 'C', 'M', 'A', 'P', 'B', 'S', '\0' };
+	constexpr std::uint32_t VERSION = 1;
+	constexpr std::uint64_t ALIGNMENT = 64;
+
+	enum class SectionType : std::uint32_t {
+		// Секции с байтами сообщений protobuf
+		TRANSPORT_CATALOGUE = 1,
+		RENDER_SETTINGS = 2,
+		ROUTE_SETTINGS = 3,
+		// Секции с сырыми массивами
+		GRAPH_EDGES = 4,
+		GRAPH_INCIDENCE_OFFSETS = 5,
+		GRAPH_INCIDENCE_EDGES = 6,
+		EDGES_INFO = 7,
+		ROUTER_CELLS = 8,
+	};
+
+	struct Header {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t sections_count;
+		// Размеры матрицы маршрутов; 0 строк, если матрица не сохранялась
+		std::uint64_t router_rows_count;
+		std::uint64_t router_vertex_count;
+		// Число вершин графа
+		std::uint64_t graph_vertex_count;
+	};
+
+	struct Section {
+		SectionType type;
+		// Размер элемента массива, 1 для байтов protobuf. Позволяет
+		// отвергнуть базу, собранную с другим размещением структур
+		std::uint32_t element_size;
+		std::uint64_t offset;
+		std::uint64_t size;
+	};
+
+	// Файл, отображенный в память только для чтения
+	class MappedFile {
+	public:
+		// nullptr, если файл не удалось открыть или отобразить
+		static std::shared_ptr<MappedFile> Open(const std::filesystem::path& path);
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile();
+
+		const char* GetData() const {
+			return data_;
+		}
+
+		std::size_t GetSize() const {
+			return size_;
+		}
+
+		// Проверяет, что файл начинается с заголовка этого формата
+		bool HasMagic() const;
+
+		// Секция заданного типа, если она есть в таблице и целиком лежит в файле
+		std::optional<Section> FindSection(SectionType type) const;
+
+		const Header& GetHeader() const {
+			return *reinterpret_cast<const Header*>(data_);
+		}
+
+	private:
+		MappedFile(const char* data, std::size_t size)
+			: data_(data)
+			, size_(size) {
+		}
+
+		const char* data_;
+		std::size_t size_;
+	};
+
+}  // namespace mapped_base
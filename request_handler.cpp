@@ -3,42 +3,36 @@
 using namespace std;
 
 // Подсчет количества остановок
-int GetStopsCount(const shared_ptr<Bus> bus) {
-	return bus.get()->stops.size();
+int GetStopsCount(const Bus& bus) {
+	return bus.stops.size();
 }
 
 // Подсчет количества уникальных остановок
-int GetUniqueStop(const shared_ptr<Bus> bus) {
-	int counter = 0;
-	auto it = bus.get()->stops.begin();
-	auto end = bus.get()->stops.end();
-
-	for (; it != end; it++) {
-		if (find(next(it), end, *it) == end) {
-			counter++;
-		}
-	}
-
-	return counter;
+int GetUniqueStop(const Bus& bus) {
+	vector<StopId> stops(bus.stops.begin(), bus.stops.end());
+	sort(stops.begin(), stops.end());
+	return unique(stops.begin(), stops.end()) - stops.begin();
 }
 
 // Подсчет длины пути по координатам
-double CalculateGeographicLength(const shared_ptr<Bus> bus) {
+double CalculateGeographicLength(const Bus& bus, const TransportCatalogue& transport_catalogue) {
 	double result = 0;
 
-	for (int i = 0; i < static_cast<int>(bus.get()->stops.size()) - 1; ++i) {
-		result += geo::ComputeDistance({ bus.get()->stops[i]->coord_x, bus.get()->stops[i]->coord_y }, { bus.get()->stops[i + 1]->coord_x, bus.get()->stops[i + 1]->coord_y });
+	for (size_t i = 1; i < bus.stops.size(); ++i) {
+		const Stop& stop_from = transport_catalogue.GetStop(bus.stops[i - 1]);
+		const Stop& stop_to = transport_catalogue.GetStop(bus.stops[i]);
+		result += geo::ComputeDistance({ stop_from.coord_x, stop_from.coord_y }, { stop_to.coord_x, stop_to.coord_y });
 	}
 
 	return result;
 }
 
 // Подсчет фактической длины пути
-double CalculateActualLength(const shared_ptr<Bus> bus, TransportCatalogue& transport_catalogue) {
+double CalculateActualLength(const Bus& bus, const TransportCatalogue& transport_catalogue) {
 	double result = 0;
 
-	for (int i = 0; i < static_cast<int>(bus.get()->stops.size()) - 1; ++i) {
-		result += transport_catalogue.GetDistanceBetweenTwoStops(bus.get()->stops[i]->name, bus.get()->stops[i + 1]->name);
+	for (size_t i = 1; i < bus.stops.size(); ++i) {
+		result += transport_catalogue.GetDistanceBetweenTwoStops(bus.stops[i - 1], bus.stops[i]);
 	}
 
 	return result;
@@ -49,39 +43,49 @@ double CalculateCurvature(double geo_length, double actual_length) {
 	return (actual_length / geo_length);
 }
 
-// Сохранение информации о маршруте в вектор bus_info_vector
+// Подсчет всей статистики маршрута
+BusStats CalculateBusStats(const Bus& bus, const TransportCatalogue& transport_catalogue) {
+	BusStats stats;
+
+	double geo_length = CalculateGeographicLength(bus, transport_catalogue);
+	stats.route_length = CalculateActualLength(bus, transport_catalogue);
+	stats.curvature = CalculateCurvature(geo_length, stats.route_length);
+	stats.stop_count = GetStopsCount(bus);
+	stats.unique_stop_count = GetUniqueStop(bus);
+
+	return stats;
+}
+
+void SetBusesStats(TransportCatalogue& transport_catalogue) {
+	for (const Bus& bus : transport_catalogue.GetBuses()) {
+		transport_catalogue.SetBusStats(bus.id, CalculateBusStats(bus, transport_catalogue));
+	}
+}
+
+// Сохранение информации о маршруте в вектор bus_info_vector.
+// Статистика посчитана заранее, при построении базы
 void GetBusInfo(TransportCatalogue& transport_catalogue, const vector<string>& words, vector<pair<string, json::Node>>& bus_info_vector) {
-	string bus_name = words.at(1);
-	shared_ptr<Bus> bus = transport_catalogue.GetBus(bus_name);
+	const Bus* bus = transport_catalogue.FindBus(words.at(1));
 
-	if (bus.get() == nullptr) {
+	if (bus == nullptr) {
 		bus_info_vector.push_back({ "error_message"s, json::Node("not found") });
 	} else {
-		double geo_length = CalculateGeographicLength(bus);
-		double actual_length = CalculateActualLength(bus, transport_catalogue);
-		double curvature = CalculateCurvature(geo_length, actual_length);
-		int stops_count = GetStopsCount(bus);
-		int unique_stops = GetUniqueStop(bus);
-
-		bus_info_vector.push_back({ "curvature"s, json::Node(curvature) });
-		bus_info_vector.push_back({ "route_length"s, json::Node(actual_length) });
-		bus_info_vector.push_back({ "stop_count"s, json::Node(stops_count) });
-		bus_info_vector.push_back({ "unique_stop_count"s, json::Node(unique_stops) });
+		bus_info_vector.push_back({ "curvature"s, json::Node(bus->stats.curvature) });
+		bus_info_vector.push_back({ "route_length"s, json::Node(bus->stats.route_length) });
+		bus_info_vector.push_back({ "stop_count"s, json::Node(bus->stats.stop_count) });
+		bus_info_vector.push_back({ "unique_stop_count"s, json::Node(bus->stats.unique_stop_count) });
 	}
 }
 
 // Сохранение информации об остановке в вектор stop_info_vector
 void GetStopInfo(TransportCatalogue& transport_catalogue, const vector<string>& words, vector<pair<string, json::Node>>& stop_info_vector) {
-	string stop_name = words[1];
-	shared_ptr<set<string>> stop_to_buses = transport_catalogue.GetStopToBuses(stop_name);
+	const Stop* stop = transport_catalogue.FindStop(words[1]);
 
-	if (stop_to_buses.get() == nullptr) {
+	if (stop == nullptr) {
 		stop_info_vector.push_back({ "error_message"s, json::Node("not found") });
-	} else if (stop_to_buses.get()->size() == 0) {
-		return;
 	} else {
-		for (const string& stop : *(stop_to_buses.get())) {
-			stop_info_vector.push_back({ "bus"s, json::Node(stop) });
+		for (const string& bus_name : stop->buses) {
+			stop_info_vector.push_back({ "bus"s, json::Node(bus_name) });
 		}
 	}
 }
@@ -13,16 +13,21 @@
 #include "transport_catalogue.h"
 #include "domain.h"
 
-int GetStopsCount(const std::shared_ptr<Bus> bus);
+int GetStopsCount(const Bus& bus);
 
-int GetUniqueStop(const std::shared_ptr<Bus> bus);
+int GetUniqueStop(const Bus& bus);
 
-double CalculateGeographicLength(const std::shared_ptr<Bus> bus);
+double CalculateGeographicLength(const Bus& bus, const TransportCatalogue& transport_catalogue);
 
-double CalculateActualLength(const std::shared_ptr<Bus> bus, TransportCatalogue& transport_catalogue);
+double CalculateActualLength(const Bus& bus, const TransportCatalogue& transport_catalogue);
 
 double CalculateCurvature(double geo_length, double actual_length);
 
+BusStats CalculateBusStats(const Bus& bus, const TransportCatalogue& transport_catalogue);
+
+// Расчет статистики всех маршрутов каталога
+void SetBusesStats(TransportCatalogue& transport_catalogue);
+
 void GetBusInfo(TransportCatalogue& transport_catalogue, const std::vector<std::string>& words, std::vector<std::pair<std::string, json::Node>>& bus_info_vector);
 
 void GetStopInfo(TransportCatalogue& transport_catalogue, const std::vector<std::string>& words, std::vector<std::pair<std::string, json::Node>>& stop_info_vector);
@@ -1,11 +1,17 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <memory>
 #include <optional>
+#include <queue>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -15,104 +21,283 @@
 namespace graph {
 
 	template <typename Weight>
-	class Router {
-	private:
-		using Graph = DirectedWeightedGraph<Weight>;
+	struct RouteInfo {
+		Weight weight;
+		std::vector<EdgeId> edges;
+	};
 
+	// Общий интерфейс движков построения маршрутов,
+	// чтобы TransportRouter мог выбирать движок при построении графа
+	template <typename Weight>
+	class RouterBase {
 	public:
-		explicit Router(const Graph& graph);
+		virtual ~RouterBase() = default;
 
-		struct RouteInfo {
-			Weight weight;
-			std::vector<EdgeId> edges;
-		};
+		virtual std::optional<RouteInfo<Weight>> BuildRoute(VertexId from, VertexId to) const = 0;
+	};
 
-		struct RouteInternalData {
-			Weight weight;
-			std::optional<EdgeId> prev_edge;
-		};
-		using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+	// Компактный номер ребра в таблицах кратчайших путей
+	using CompactEdgeId = std::uint32_t;
 
-		std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+	// Вершина - начало маршрута, входящего ребра нет
+	inline constexpr CompactEdgeId NO_PREV_EDGE = static_cast<CompactEdgeId>(-2);
+	// Вершина недостижима из начала маршрута
+	inline constexpr CompactEdgeId UNREACHABLE = static_cast<CompactEdgeId>(-1);
 
-		RoutesInternalData& GetInternalData(){
-			return routes_internal_data_;
-		}
+	// Строка кратчайших путей из одной вершины: вес пути до каждой
+	// вершины и последнее ребро этого пути
+	template <typename Weight>
+	struct ShortestPathRow {
+		std::vector<Weight> weights;
+		std::vector<CompactEdgeId> prev_edges;
+	};
 
-	private:
-		void InitializeRoutesInternalData(const Graph& graph) {
-			const size_t vertex_count = graph.GetVertexCount();
-			for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-				routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, std::nullopt };
-				for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-					const auto& edge = graph.GetEdge(edge_id);
-					if (edge.weight < ZERO_WEIGHT) {
-						throw std::domain_error("Edges' weights should be non-negative");
-					}
-					auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-					if (!route_internal_data || route_internal_data->weight > edge.weight) {
-						route_internal_data = RouteInternalData{ edge.weight, edge_id };
-					}
+	// Заполняет row деревом кратчайших путей из вершины from (алгоритм Дейкстры).
+	// Память row переиспользуется между вызовами
+	template <typename Weight>
+	void FillShortestPathRow(const DirectedWeightedGraph<Weight>& graph, VertexId from, ShortestPathRow<Weight>& row) {
+		using QueueEntry = std::pair<Weight, VertexId>;
+		static constexpr Weight ZERO_WEIGHT{};
+
+		const size_t vertex_count = graph.GetVertexCount();
+		row.weights.assign(vertex_count, ZERO_WEIGHT);
+		row.prev_edges.assign(vertex_count, UNREACHABLE);
+
+		std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+		row.prev_edges.at(from) = NO_PREV_EDGE;
+		queue.push({ ZERO_WEIGHT, from });
+
+		while (!queue.empty()) {
+			const auto [weight, vertex] = queue.top();
+			queue.pop();
+			if (row.weights[vertex] < weight) {
+				continue;
+			}
+			for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+				const auto& edge = graph.GetEdge(edge_id);
+				const Weight candidate_weight = weight + edge.weight;
+				if (row.prev_edges[edge.to] == UNREACHABLE || candidate_weight < row.weights[edge.to]) {
+					row.weights[edge.to] = candidate_weight;
+					row.prev_edges[edge.to] = static_cast<CompactEdgeId>(edge_id);
+					queue.push({ candidate_weight, edge.to });
 				}
 			}
 		}
+	}
+
+	template <typename Weight>
+	ShortestPathRow<Weight> BuildShortestPathRow(const DirectedWeightedGraph<Weight>& graph, VertexId from) {
+		ShortestPathRow<Weight> row;
+		FillShortestPathRow(graph, from, row);
+		return row;
+	}
 
-		void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-			const RouteInternalData& route_to) {
-			auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-			const Weight candidate_weight = route_from.weight + route_to.weight;
-			if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-				route_relaxing = { candidate_weight,
-								  route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge };
+	// Проверка, что граф подходит для алгоритма Дейкстры
+	// и его ребра помещаются в CompactEdgeId
+	template <typename Weight>
+	void CheckGraphForShortestPaths(const DirectedWeightedGraph<Weight>& graph) {
+		static constexpr Weight ZERO_WEIGHT{};
+
+		if (graph.GetEdgeCount() >= static_cast<size_t>(NO_PREV_EDGE)) {
+			throw std::length_error("Too many edges for compact edge ids");
+		}
+		for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+			if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+				throw std::domain_error("Edges' weights should be non-negative");
 			}
 		}
+	}
+
+	// Матрица маршрутов из первых rows_count вершин во все вершины графа,
+	// хранящаяся построчно в одном непрерывном буфере. Вместо std::optional
+	// используются значения NO_PREV_EDGE и UNREACHABLE в поле prev_edge
+	template <typename StoredWeight>
+	class RoutesMatrix {
+	public:
+		struct Cell {
+			StoredWeight weight;
+			CompactEdgeId prev_edge;
+		};
+		static_assert(std::is_trivially_copyable_v<Cell>, "Cells are serialized as raw bytes");
+
+		RoutesMatrix() = default;
+
+		RoutesMatrix(size_t rows_count, size_t vertex_count) {
+			Resize(rows_count, vertex_count);
+		}
+
+		// Ячейки адресуются через cells_, поэтому копирование запрещено,
+		// а перемещение сохраняет указатель на буфер
+		RoutesMatrix(const RoutesMatrix&) = delete;
+		RoutesMatrix& operator=(const RoutesMatrix&) = delete;
+		RoutesMatrix(RoutesMatrix&&) = default;
+		RoutesMatrix& operator=(RoutesMatrix&&) = default;
+
+		size_t GetRowsCount() const {
+			return rows_count_;
+		}
+
+		size_t GetVertexCount() const {
+			return vertex_count_;
+		}
+
+		size_t GetCellsCount() const {
+			return rows_count_ * vertex_count_;
+		}
 
-		void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-			for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-				if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-					for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-						if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-							RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-						}
-					}
+		Cell& At(VertexId from, VertexId to) {
+			return GetData()[from * vertex_count_ + to];
+		}
+		const Cell& At(VertexId from, VertexId to) const {
+			return cells_[from * vertex_count_ + to];
+		}
+
+		Cell* GetRow(VertexId from) {
+			return GetData() + from * vertex_count_;
+		}
+		const Cell* GetRow(VertexId from) const {
+			return cells_ + from * vertex_count_;
+		}
+
+		// Весь буфер целиком - для сериализации. Менять можно
+		// только собственный буфер, а не чужую память
+		Cell* GetData() {
+			if (owner_) {
+				throw std::logic_error("Routes matrix is read-only");
+			}
+			return storage_.data();
+		}
+		const Cell* GetData() const {
+			return cells_;
+		}
+
+		void Resize(size_t rows_count, size_t vertex_count) {
+			rows_count_ = rows_count;
+			vertex_count_ = vertex_count;
+			owner_.reset();
+			storage_.assign(rows_count * vertex_count, Cell{ StoredWeight{}, UNREACHABLE });
+			cells_ = storage_.data();
+		}
+
+		// Матрица поверх чужого буфера без копирования. owner продлевает
+		// жизнь памяти, в которой лежат ячейки
+		void View(size_t rows_count, size_t vertex_count, const Cell* cells, std::shared_ptr<const void> owner) {
+			rows_count_ = rows_count;
+			vertex_count_ = vertex_count;
+			storage_.clear();
+			storage_.shrink_to_fit();
+			owner_ = std::move(owner);
+			cells_ = cells;
+		}
+
+	private:
+		size_t rows_count_ = 0;
+		size_t vertex_count_ = 0;
+		std::vector<Cell> storage_;
+		std::shared_ptr<const void> owner_;
+		const Cell* cells_ = nullptr;
+	};
+
+	// Движок с предрасчетом маршрутов из первых sources_count вершин графа
+	// (по умолчанию - из всех) во все вершины. Строки матрицы считаются
+	// алгоритмом Дейкстры из каждой вершины параллельно в threads_count потоках:
+	// потоки забирают номера следующих строк из общего атомарного счетчика.
+	// StoredWeight - тип весов в матрице: если он отличается от Weight
+	// (например, float для экономии памяти), вес найденного маршрута
+	// пересчитывается по ребрам графа с точностью Weight
+	template <typename Weight, typename StoredWeight = Weight>
+	class Router final : public RouterBase<Weight> {
+	private:
+		using Graph = DirectedWeightedGraph<Weight>;
+
+	public:
+		explicit Router(const Graph& graph);
+
+		Router(const Graph& graph, size_t sources_count, size_t threads_count);
+
+		using RouteInfo = graph::RouteInfo<Weight>;
+		using RoutesInternalData = RoutesMatrix<StoredWeight>;
+		using RouteInternalData = typename RoutesInternalData::Cell;
+
+		std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+		RoutesInternalData& GetInternalData(){
+			return routes_internal_data_;
+		}
+
+	private:
+		// Считает строки матрицы, пока в счетчике next_vertex есть необработанные вершины
+		void FillRoutesInternalData(std::atomic<VertexId>& next_vertex) {
+			const size_t rows_count = routes_internal_data_.GetRowsCount();
+			const size_t vertex_count = routes_internal_data_.GetVertexCount();
+			ShortestPathRow<Weight> row;
+			for (VertexId vertex_from = next_vertex++; vertex_from < rows_count; vertex_from = next_vertex++) {
+				FillShortestPathRow(graph_, vertex_from, row);
+				RouteInternalData* row_from = routes_internal_data_.GetRow(vertex_from);
+				for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+					row_from[vertex_to] = { static_cast<StoredWeight>(row.weights[vertex_to]), row.prev_edges[vertex_to] };
 				}
 			}
 		}
 
-		static constexpr Weight ZERO_WEIGHT{};
 		const Graph& graph_;
 		RoutesInternalData routes_internal_data_;
 	};
 
-	template <typename Weight>
-	Router<Weight>::Router(const Graph& graph)
+	template <typename Weight, typename StoredWeight>
+	Router<Weight, StoredWeight>::Router(const Graph& graph)
+		: Router(graph, graph.GetVertexCount(), 1) {
+	}
+
+	template <typename Weight, typename StoredWeight>
+	Router<Weight, StoredWeight>::Router(const Graph& graph, size_t sources_count, size_t threads_count)
 		: graph_(graph)
-		, routes_internal_data_(graph.GetVertexCount(),
-			std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount())) {
-		InitializeRoutesInternalData(graph);
+		, routes_internal_data_(std::min(sources_count, graph.GetVertexCount()), graph.GetVertexCount()) {
+		CheckGraphForShortestPaths(graph);
 
-		const size_t vertex_count = graph.GetVertexCount();
-		for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-			RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+		threads_count = std::max<size_t>(1, std::min(threads_count, routes_internal_data_.GetRowsCount()));
+		std::atomic<VertexId> next_vertex{ 0 };
+
+		std::vector<std::thread> threads;
+		threads.reserve(threads_count - 1);
+		for (size_t i = 1; i < threads_count; ++i) {
+			threads.emplace_back([this, &next_vertex] {
+				FillRoutesInternalData(next_vertex);
+			});
+		}
+		FillRoutesInternalData(next_vertex);
+		for (std::thread& thread : threads) {
+			thread.join();
 		}
 	}
 
-	template <typename Weight>
-	std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
+	template <typename Weight, typename StoredWeight>
+	std::optional<typename Router<Weight, StoredWeight>::RouteInfo> Router<Weight, StoredWeight>::BuildRoute(VertexId from,
 		VertexId to) const {
-		const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-		if (!route_internal_data) {
+		if (from >= routes_internal_data_.GetRowsCount() || to >= routes_internal_data_.GetVertexCount()) {
+			throw std::out_of_range("Vertex id is out of range");
+		}
+		const auto& route_internal_data = routes_internal_data_.At(from, to);
+		if (route_internal_data.prev_edge == UNREACHABLE) {
 			return std::nullopt;
 		}
-		const Weight weight = route_internal_data->weight;
 		std::vector<EdgeId> edges;
-		for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-			edge_id;
-			edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge) {
-			edges.push_back(*edge_id);
+		for (CompactEdgeId edge_id = route_internal_data.prev_edge;
+			edge_id != NO_PREV_EDGE;
+			edge_id = routes_internal_data_.At(from, graph_.GetEdge(edge_id).from).prev_edge) {
+			edges.push_back(edge_id);
 		}
 		std::reverse(edges.begin(), edges.end());
 
+		Weight weight{};
+		if constexpr (std::is_same_v<Weight, StoredWeight>) {
+			weight = route_internal_data.weight;
+		} else {
+			for (const EdgeId edge_id : edges) {
+				weight += graph_.GetEdge(edge_id).weight;
+			}
+		}
+
 		return RouteInfo{ weight, std::move(edges) };
 	}
 
@@ -5,114 +5,481 @@ void Serialization::Serialize(TransportCatalogue& transport_catalogue, MapRender
 	if (!out)
 		return;
 
-	transport_proto::Container container;
+	if (serialization_settings_.format == BaseFormat::MAPPED) {
+		SerializeMapped_(out, transport_catalogue, map_renderer, transport_router);
+		return;
+	}
+
+	using Container = transport_proto::Container;
+
+	// Крупные секции не зависят друг от друга и только читают данные,
+	// поэтому переводятся в proto одновременно
+	auto catalogue_future = std::async(std::launch::async, [&] { return ConvertTransportCatalogue_(transport_catalogue); });
+	auto graph_future = std::async(std::launch::async, [&] { return ConvertGraph_(transport_router); });
+	auto edges_info_future = std::async(std::launch::async, [&] { return ConvertEdgesInfo_(transport_router); });
+
+	// Секции пишутся в файл по одной, по мере готовности, без общего
+	// сообщения Container. Порядок полей protobuf не важен, но настройки
+	// маршрутизации должны идти раньше матрицы, а ее заголовок - раньше блоков
+	google::protobuf::io::OstreamOutputStream output_stream(&out);
+	google::protobuf::io::CodedOutputStream output(&output_stream);
+
+	WriteSection_(output, Container::kRenderSettingsFieldNumber, ConvertRenderSettings_(map_renderer.GetRenderSettings()));
+	WriteSection_(output, Container::kRouteSettingsFieldNumber, ConvertRouteSettings_(transport_router.GetRouteSettings()));
+	// Для остальных движков нечего сохранять: они строятся над графом при загрузке
+	if (transport_router.GetRouteSettings().router_type == RouterType::ALL_PAIRS)
+		WriteRouter_(output, transport_router.GetAllPairsRouter()->GetInternalData());
+	WriteSection_(output, Container::kTransportCatalogueFieldNumber, catalogue_future.get());
+	WriteSection_(output, Container::kGraphFieldNumber, graph_future.get());
+	WriteSection_(output, Container::kEdgesInfoFieldNumber, edges_info_future.get());
+
+	if (output.HadError())
+		throw std::runtime_error("Failed to write the base");
+}
+
+void Serialization::WriteSection_(google::protobuf::io::CodedOutputStream& output, int field_number,
+	const google::protobuf::MessageLite& message){
+	using google::protobuf::internal::WireFormatLite;
+
+	// Длину секции длиннее INT_MAX protobuf не разберет при загрузке
+	const size_t length = message.ByteSizeLong();
+	if (length > static_cast<size_t>(std::numeric_limits<int>::max()))
+		throw std::runtime_error("Base section is too large");
 
-	*(container.mutable_transport_catalogue()) = ConvertTransportCatalogue_(transport_catalogue);
-	*(container.mutable_render_settings()) = ConvertRenderSettings_(map_renderer.GetRenderSettings());
-	*(container.mutable_route_settings()) = ConvertRouteSettings_(transport_router.GetRouteSettings());
-	*(container.mutable_router()) = ConvertRouter_(transport_router);
-	*(container.mutable_graph()) = ConvertGraph_(transport_router);
+	WireFormatLite::WriteTag(field_number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, &output);
+	output.WriteVarint32(static_cast<uint32_t>(length));
+	message.SerializeWithCachedSizes(&output);
+}
+
+void Serialization::WriteRouter_(google::protobuf::io::CodedOutputStream& output,
+	const AllPairsRouter::RoutesInternalData& routes_internal_data){
+	const size_t rows_count = routes_internal_data.GetRowsCount();
 
-	container.SerializeToOstream(&out);
+	transport_proto::Router converted_router;
+	converted_router.set_rows_count(rows_count);
+	converted_router.set_vertex_count(routes_internal_data.GetVertexCount());
+	converted_router.set_encoding(static_cast<uint32_t>(serialization_settings_.router_encoding));
+	WriteSection_(output, transport_proto::Container::kRouterFieldNumber, converted_router);
+
+	// В proto переводится только текущий блок строк
+	for (graph::VertexId first_row = 0; first_row < rows_count; first_row += ROUTER_BLOCK_ROWS){
+		WriteSection_(output, transport_proto::Container::kRouterBlocksFieldNumber,
+			ConvertRouterBlock_(routes_internal_data, first_row, std::min(ROUTER_BLOCK_ROWS, rows_count - first_row)));
+	}
 }
 
-void Serialization::Deserialize(TransportCatalogue& transport_catalogue, MapRenderer& map_renderer, TransportRouter& transport_router){
-	std::ifstream in(serialization_settings_.file_name, std::ios::binary);
-	if (!in)
+// Загружаются только секции из sections: например, для запросов
+// Bus и Stop не нужны ни граф, ни матрица маршрутов
+void Serialization::Deserialize(TransportCatalogue& transport_catalogue, MapRenderer& map_renderer, TransportRouter& transport_router,
+	const BaseSections& sections){
+	std::shared_ptr<mapped_base::MappedFile> mapped_file = mapped_base::MappedFile::Open(serialization_settings_.file_name);
+	if (!mapped_file)
 		return;
 
-	transport_proto::Container container;
-	if (!container.ParseFromIstream(&in))
+	if (mapped_file->HasMagic()) {
+		DeserializeMapped_(std::move(mapped_file), transport_catalogue, map_renderer, transport_router, sections);
 		return;
+	}
 
-	transport_catalogue = ConvertProtoTransportCatalogue_(*container.mutable_transport_catalogue());
-	map_renderer.SetRenderSettings(ConvertProtoRenderSettings_(*container.mutable_render_settings()));
-	ConvertProtoRouteSettings_(transport_router.GetRouteSettings(), *container.mutable_route_settings());
-	ConvertProtoGraph_(*container.mutable_graph(), transport_router.GetGraph());
-	ConvertProtoRouter_(*container.mutable_router(), transport_router.GetRouter());
+	DeserializeProtobuf_(*mapped_file, transport_catalogue, map_renderer, transport_router, sections);
+}
+
+void Serialization::DeserializeProtobuf_(const mapped_base::MappedFile& mapped_file, TransportCatalogue& transport_catalogue,
+	MapRenderer& map_renderer, TransportRouter& transport_router, const BaseSections& sections){
+	using google::protobuf::internal::WireFormatLite;
+	using Container = transport_proto::Container;
+
+	const char* const data = mapped_file.GetData();
+	const size_t size = mapped_file.GetSize();
+	// CodedInputStream хранит позицию в int и не читает дальше 2 ГиБ,
+	// поэтому смещение в файле ведется отдельно, а поток создается
+	// заново на каждую секцию. Сама секция не длиннее INT_MAX
+	size_t offset = 0;
+
+	// Поле разбирается прямо из отображенного файла
+	auto parse_field = [&](google::protobuf::io::CodedInputStream& input, uint32_t tag, google::protobuf::MessageLite& field) {
+		uint32_t length = 0;
+		if (WireFormatLite::GetTagWireType(tag) != WireFormatLite::WIRETYPE_LENGTH_DELIMITED || !input.ReadVarint32(&length))
+			throw std::runtime_error("Base file is corrupted");
+		offset += input.CurrentPosition();
+		if (length > static_cast<uint32_t>(std::numeric_limits<int>::max()) || length > size - offset
+			|| !field.ParseFromArray(data + offset, static_cast<int>(length)))
+			throw std::runtime_error("Base file is corrupted");
+		offset += length;
+	};
+
+	auto load_router = [&] {
+		return sections.routing && transport_router.GetRouteSettings().router_type == RouterType::ALL_PAIRS;
+	};
+	std::optional<RouterEncoding> router_encoding;
+	size_t router_rows_read = 0;
+
+	// Каждая секция переводится сразу после разбора, а матрица маршрутов
+	// заполняется по блокам, так что в proto не бывает всей базы целиком
+	while (offset < size) {
+		google::protobuf::io::CodedInputStream input(reinterpret_cast<const uint8_t*>(data + offset),
+			static_cast<int>(std::min<size_t>(size - offset, std::numeric_limits<int>::max())));
+		const uint32_t tag = input.ReadTag();
+		if (tag == 0)
+			throw std::runtime_error("Base file is corrupted");
+
+		switch (WireFormatLite::GetTagFieldNumber(tag)) {
+		case Container::kTransportCatalogueFieldNumber: {
+			transport_proto::TransportCatalogue converted_catalogue;
+			parse_field(input, tag, converted_catalogue);
+			transport_catalogue = ConvertProtoTransportCatalogue_(converted_catalogue);
+			continue;
+		}
+		case Container::kRenderSettingsFieldNumber:
+			if (sections.render_settings) {
+				transport_proto::RenderSettings converted_settings;
+				parse_field(input, tag, converted_settings);
+				map_renderer.SetRenderSettings(ConvertProtoRenderSettings_(converted_settings));
+				continue;
+			}
+			break;
+		case Container::kRouteSettingsFieldNumber:
+			if (sections.routing) {
+				transport_proto::RouteSettings converted_settings;
+				parse_field(input, tag, converted_settings);
+				ConvertProtoRouteSettings_(transport_router.GetRouteSettings(), converted_settings);
+				continue;
+			}
+			break;
+		case Container::kGraphFieldNumber:
+			if (sections.routing) {
+				transport_proto::Graph converted_graph;
+				parse_field(input, tag, converted_graph);
+				ConvertProtoGraph_(converted_graph, transport_router.GetGraph());
+				continue;
+			}
+			break;
+		case Container::kEdgesInfoFieldNumber:
+			if (sections.routing) {
+				transport_proto::EdgesInfo converted_edges_info;
+				parse_field(input, tag, converted_edges_info);
+				ConvertProtoEdgesInfo_(converted_edges_info, transport_router.GetEdgesInfo());
+				continue;
+			}
+			break;
+		case Container::kRouterFieldNumber:
+			if (load_router()) {
+				transport_proto::Router converted_router;
+				parse_field(input, tag, converted_router);
+				if (converted_router.encoding() > static_cast<uint32_t>(RouterEncoding::SPARSE_GZIP))
+					throw std::runtime_error("Unknown router matrix encoding in the base");
+				router_encoding = static_cast<RouterEncoding>(converted_router.encoding());
+				transport_router.GetAllPairsRouter()->GetInternalData().Resize(converted_router.rows_count(),
+					converted_router.vertex_count());
+				continue;
+			}
+			break;
+		case Container::kRouterBlocksFieldNumber:
+			if (load_router()) {
+				if (!router_encoding)
+					throw std::runtime_error("Router matrix in the base is corrupted");
+				transport_proto::RouterBlock converted_block;
+				parse_field(input, tag, converted_block);
+				// Блоки идут подряд и покрывают каждую строку ровно один раз
+				if (converted_block.first_row() != router_rows_read)
+					throw std::runtime_error("Router matrix in the base is corrupted");
+				ConvertProtoRouterBlock_(converted_block, *router_encoding, transport_router.GetAllPairsRouter()->GetInternalData());
+				router_rows_read += converted_block.rows_count();
+				continue;
+			}
+			break;
+		}
+
+		// Ненужное поле пропускается без разбора
+		if (!WireFormatLite::SkipField(&input, tag))
+			throw std::runtime_error("Base file is corrupted");
+		offset += input.CurrentPosition();
+	}
+
+	if (!sections.routing)
+		return;
+	if (!load_router()) {
+		transport_router.SetRouter();
+		return;
+	}
+
+	// В разреженной записи нет весов, но они и не нужны: AllPairsRouter
+	// считает вес маршрута по ребрам графа, а не берет из матрицы
+	if (!router_encoding || router_rows_read != transport_router.GetAllPairsRouter()->GetInternalData().GetRowsCount())
+		throw std::runtime_error("Router matrix in the base is corrupted");
 }
 
 void Serialization::SetSerializationSettings(SerializationSettings serialization_settings){
 	serialization_settings_ = serialization_settings;
 }
 
-transport_proto::TransportCatalogue Serialization::ConvertTransportCatalogue_(TransportCatalogue& transport_catalogue){
+void Serialization::SerializeMapped_(std::ofstream& out, TransportCatalogue& transport_catalogue,
+	MapRenderer& map_renderer, TransportRouter& transport_router){
+	using namespace mapped_base;
+	static_assert(std::is_trivially_copyable_v<graph::Edge<double>>, "Edges are stored as raw bytes");
+	static_assert(std::is_trivially_copyable_v<EdgeInfo>, "Edges info is stored as raw bytes");
+	// Байты выравнивания попали бы в файл как есть, и одинаковые базы различались бы
+	static_assert(sizeof(graph::Edge<double>) == 2 * sizeof(graph::VertexId) + sizeof(double), "Edges have no padding");
+	static_assert(sizeof(AllPairsRouter::RouteInternalData) == sizeof(float) + sizeof(graph::CompactEdgeId),
+		"Router cells have no padding");
+
+	struct Payload {
+		SectionType type;
+		size_t element_size;
+		const char* data;
+		size_t size;
+	};
+
+	// Небольшие секции с настройками и каталогом пишутся как сообщения protobuf
+	const std::string catalogue_bytes = ConvertTransportCatalogue_(transport_catalogue).SerializeAsString();
+	const std::string render_settings_bytes = ConvertRenderSettings_(map_renderer.GetRenderSettings()).SerializeAsString();
+	const std::string route_settings_bytes = ConvertRouteSettings_(transport_router.GetRouteSettings()).SerializeAsString();
+
+	const graph::DirectedWeightedGraph<double>& graph = *transport_router.GetGraph();
+	const std::vector<EdgeInfo>& edges_info = transport_router.GetEdgesInfo();
+
+	// В EdgeInfo есть байты выравнивания, поэтому он копируется по полям
+	// в обнуленный буфер. Размещение в файле остается тем же, что в памяти
+	std::vector<char> edges_info_bytes(edges_info.size() * sizeof(EdgeInfo));
+	for (size_t i = 0; i < edges_info.size(); ++i) {
+		char* bytes = edges_info_bytes.data() + i * sizeof(EdgeInfo);
+		std::memcpy(bytes + offsetof(EdgeInfo, type), &edges_info[i].type, sizeof(EdgeInfo::type));
+		std::memcpy(bytes + offsetof(EdgeInfo, stop_id), &edges_info[i].stop_id, sizeof(EdgeInfo::stop_id));
+		std::memcpy(bytes + offsetof(EdgeInfo, bus_id), &edges_info[i].bus_id, sizeof(EdgeInfo::bus_id));
+		std::memcpy(bytes + offsetof(EdgeInfo, span_count), &edges_info[i].span_count, sizeof(EdgeInfo::span_count));
+	}
+
+	std::vector<Payload> payloads = {
+		{ SectionType::TRANSPORT_CATALOGUE, 1, catalogue_bytes.data(), catalogue_bytes.size() },
+		{ SectionType::RENDER_SETTINGS, 1, render_settings_bytes.data(), render_settings_bytes.size() },
+		{ SectionType::ROUTE_SETTINGS, 1, route_settings_bytes.data(), route_settings_bytes.size() },
+		{ SectionType::GRAPH_EDGES, sizeof(graph::Edge<double>), reinterpret_cast<const char*>(graph.GetEdgesData()),
+			graph.GetEdgeCount() * sizeof(graph::Edge<double>) },
+		{ SectionType::GRAPH_INCIDENCE_OFFSETS, sizeof(graph::EdgeId), reinterpret_cast<const char*>(graph.GetIncidenceOffsetsData()),
+			(graph.GetVertexCount() + 1) * sizeof(graph::EdgeId) },
+		{ SectionType::GRAPH_INCIDENCE_EDGES, sizeof(graph::EdgeId), reinterpret_cast<const char*>(graph.GetIncidenceEdgesData()),
+			graph.GetEdgeCount() * sizeof(graph::EdgeId) },
+		{ SectionType::EDGES_INFO, sizeof(EdgeInfo), edges_info_bytes.data(), edges_info_bytes.size() },
+	};
+
+	Header header{};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.graph_vertex_count = graph.GetVertexCount();
+	// Для остальных движков нечего сохранять: они строятся над графом при загрузке
+	if (transport_router.GetRouteSettings().router_type == RouterType::ALL_PAIRS) {
+		const auto& routes_internal_data = transport_router.GetAllPairsRouter()->GetInternalData();
+		header.router_rows_count = routes_internal_data.GetRowsCount();
+		header.router_vertex_count = routes_internal_data.GetVertexCount();
+		payloads.push_back({ SectionType::ROUTER_CELLS, sizeof(AllPairsRouter::RouteInternalData),
+			reinterpret_cast<const char*>(std::as_const(routes_internal_data).GetData()),
+			routes_internal_data.GetCellsCount() * sizeof(AllPairsRouter::RouteInternalData) });
+	}
+	header.sections_count = payloads.size();
+
+	auto align_up = [](uint64_t offset) {
+		return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	};
+
+	std::vector<Section> sections;
+	uint64_t offset = align_up(sizeof(Header) + payloads.size() * sizeof(Section));
+	for (const Payload& payload : payloads) {
+		sections.push_back({ payload.type, static_cast<uint32_t>(payload.element_size), offset, payload.size });
+		offset = align_up(offset + payload.size);
+	}
+
+	out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	out.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(Section));
+	uint64_t written = sizeof(Header) + sections.size() * sizeof(Section);
+	const char padding[ALIGNMENT] = {};
+	for (size_t i = 0; i < payloads.size(); ++i) {
+		out.write(padding, sections[i].offset - written);
+		out.write(payloads[i].data, payloads[i].size);
+		written = sections[i].offset + payloads[i].size;
+	}
+}
+
+std::pair<const char*, size_t> Serialization::GetMappedSection_(const mapped_base::MappedFile& mapped_file,
+	mapped_base::SectionType type, size_t element_size){
+	std::optional<mapped_base::Section> section = mapped_file.FindSection(type);
+	if (!section || section->element_size != element_size || section->size % element_size != 0) {
+		throw std::runtime_error("Base section is missing or corrupted");
+	}
+	return { mapped_file.GetData() + section->offset, section->size };
+}
+
+// Каталог и настройки разбираются из небольших секций protobuf,
+// а граф и матрица маршрутов смотрят прямо в отображенный файл
+void Serialization::DeserializeMapped_(std::shared_ptr<mapped_base::MappedFile> mapped_file, TransportCatalogue& transport_catalogue,
+	MapRenderer& map_renderer, TransportRouter& transport_router, const BaseSections& sections){
+	using namespace mapped_base;
+
+	const Header& header = mapped_file->GetHeader();
+	if (header.version != VERSION)
+		throw std::runtime_error("Unsupported base version");
+
+	auto [catalogue_data, catalogue_size] = GetMappedSection_(*mapped_file, SectionType::TRANSPORT_CATALOGUE, 1);
 	transport_proto::TransportCatalogue converted_catalogue;
+	if (!converted_catalogue.ParseFromArray(catalogue_data, catalogue_size))
+		throw std::runtime_error("Base section is missing or corrupted");
+	transport_catalogue = ConvertProtoTransportCatalogue_(converted_catalogue);
+
+	if (sections.render_settings) {
+		auto [render_data, render_size] = GetMappedSection_(*mapped_file, SectionType::RENDER_SETTINGS, 1);
+		transport_proto::RenderSettings converted_render_settings;
+		if (!converted_render_settings.ParseFromArray(render_data, render_size))
+			throw std::runtime_error("Base section is missing or corrupted");
+		map_renderer.SetRenderSettings(ConvertProtoRenderSettings_(converted_render_settings));
+	}
+	if (!sections.routing)
+		return;
 
-	for (const auto& [stop_name, original_stop] : transport_catalogue.GetStops()){
-		converted_catalogue.add_stops_list();            
+	auto [route_data, route_size] = GetMappedSection_(*mapped_file, SectionType::ROUTE_SETTINGS, 1);
+	transport_proto::RouteSettings converted_route_settings;
+	if (!converted_route_settings.ParseFromArray(route_data, route_size))
+		throw std::runtime_error("Base section is missing or corrupted");
+	ConvertProtoRouteSettings_(transport_router.GetRouteSettings(), converted_route_settings);
+
+	auto [edges_data, edges_size] = GetMappedSection_(*mapped_file, SectionType::GRAPH_EDGES, sizeof(graph::Edge<double>));
+	auto [offsets_data, offsets_size] = GetMappedSection_(*mapped_file, SectionType::GRAPH_INCIDENCE_OFFSETS, sizeof(graph::EdgeId));
+	auto [incidence_data, incidence_size] = GetMappedSection_(*mapped_file, SectionType::GRAPH_INCIDENCE_EDGES, sizeof(graph::EdgeId));
+	const size_t vertex_count = header.graph_vertex_count;
+	const size_t edge_count = edges_size / sizeof(graph::Edge<double>);
+	const graph::Edge<double>* edges = reinterpret_cast<const graph::Edge<double>*>(edges_data);
+	const graph::EdgeId* incidence_offsets = reinterpret_cast<const graph::EdgeId*>(offsets_data);
+	const graph::EdgeId* incidence_edges = reinterpret_cast<const graph::EdgeId*>(incidence_data);
+	// Сначала размеры, затем каждый номер: база используется на месте,
+	// и испорченный номер означал бы чтение за пределами секции
+	if (offsets_size / sizeof(graph::EdgeId) == 0 || offsets_size / sizeof(graph::EdgeId) - 1 != vertex_count
+		|| incidence_size / sizeof(graph::EdgeId) != edge_count
+		|| incidence_offsets[0] != 0 || incidence_offsets[vertex_count] != edge_count)
+		throw std::runtime_error("Graph in the base is corrupted");
+	for (graph::VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+		if (incidence_offsets[vertex] > incidence_offsets[vertex + 1])
+			throw std::runtime_error("Graph in the base is corrupted");
+		for (graph::EdgeId i = incidence_offsets[vertex]; i < incidence_offsets[vertex + 1]; ++i) {
+			if (incidence_edges[i] >= edge_count || edges[incidence_edges[i]].from != vertex)
+				throw std::runtime_error("Graph in the base is corrupted");
+		}
 	}
-	for (const auto& [stop_name, original_stop] : transport_catalogue.GetStops()){
-		transport_proto::Stop* new_converted_stop = converted_catalogue.mutable_stops_list(original_stop.get()->id);            
-		
-		new_converted_stop->set_name(original_stop.get()->name);
-		new_converted_stop->set_coord_x(original_stop.get()->coord_x);
-		new_converted_stop->set_coord_y(original_stop.get()->coord_y);
-		new_converted_stop->set_id(original_stop.get()->id);
+	for (size_t i = 0; i < edge_count; ++i) {
+		if (edges[i].from >= vertex_count || edges[i].to >= vertex_count)
+			throw std::runtime_error("Graph in the base is corrupted");
+	}
+	*transport_router.GetGraph() = graph::DirectedWeightedGraph<double>::View(vertex_count, edge_count,
+		edges, incidence_offsets, incidence_edges, mapped_file);
+
+	auto [edges_info_data, edges_info_size] = GetMappedSection_(*mapped_file, SectionType::EDGES_INFO, sizeof(EdgeInfo));
+	if (edges_info_size / sizeof(EdgeInfo) != edge_count)
+		throw std::runtime_error("Edges info in the base is corrupted");
+	const EdgeInfo* edges_info = reinterpret_cast<const EdgeInfo*>(edges_info_data);
+	const size_t stops_count = transport_catalogue.GetStopsCount();
+	const size_t buses_count = std::distance(transport_catalogue.GetBuses().begin(), transport_catalogue.GetBuses().end());
+	for (size_t i = 0; i < edge_count; ++i) {
+		if (static_cast<std::underlying_type_t<EdgeType>>(edges_info[i].type) > static_cast<std::underlying_type_t<EdgeType>>(EdgeType::ALIGHT)
+			|| edges_info[i].stop_id >= stops_count || edges_info[i].bus_id >= buses_count)
+			throw std::runtime_error("Edges info in the base is corrupted");
+	}
+	transport_router.GetEdgesInfo().assign(edges_info, edges_info + edge_count);
+
+	if (transport_router.GetRouteSettings().router_type == RouterType::ALL_PAIRS) {
+		auto [cells_data, cells_size] = GetMappedSection_(*mapped_file, SectionType::ROUTER_CELLS, sizeof(AllPairsRouter::RouteInternalData));
+		const size_t rows_count = header.router_rows_count;
+		const size_t cells_count = cells_size / sizeof(AllPairsRouter::RouteInternalData);
+		// Делением, а не умножением: произведение испорченных размеров может переполниться
+		if (header.router_vertex_count != vertex_count || rows_count > vertex_count
+			|| (vertex_count == 0 ? cells_count != 0 : cells_count % vertex_count != 0 || cells_count / vertex_count != rows_count))
+			throw std::runtime_error("Router matrix in the base is corrupted");
+		const AllPairsRouter::RouteInternalData* cells = reinterpret_cast<const AllPairsRouter::RouteInternalData*>(cells_data);
+		for (size_t i = 0; i < cells_count; ++i) {
+			// Ребро в ячейку (from, to) обязано вести в вершину to
+			const graph::CompactEdgeId prev_edge = cells[i].prev_edge;
+			if (prev_edge != graph::UNREACHABLE && prev_edge != graph::NO_PREV_EDGE
+				&& (prev_edge >= edge_count || edges[prev_edge].to != i % vertex_count))
+				throw std::runtime_error("Router matrix in the base is corrupted");
+		}
+		transport_router.GetAllPairsRouter()->GetInternalData().View(rows_count, vertex_count, cells, mapped_file);
+	} else {
+		transport_router.SetRouter();
+	}
+}
+
+transport_proto::TransportCatalogue Serialization::ConvertTransportCatalogue_(TransportCatalogue& transport_catalogue){
+	transport_proto::TransportCatalogue converted_catalogue;
+
+	// Остановки и маршруты хранятся в каталоге в порядке своих номеров,
+	// поэтому при загрузке они получат те же номера
+	for (const Stop& original_stop : transport_catalogue.GetStops()){
+		transport_proto::Stop* new_converted_stop = converted_catalogue.add_stops_list();
+
+		new_converted_stop->set_name(original_stop.name);
+		new_converted_stop->set_coord_x(original_stop.coord_x);
+		new_converted_stop->set_coord_y(original_stop.coord_y);
+		new_converted_stop->set_id(original_stop.id);
 	}
 
-	for (const auto& [bus_name, original_bus] : transport_catalogue.GetBuses()){
+	for (const Bus& original_bus : transport_catalogue.GetBuses()){
 		transport_proto::Bus* new_converted_bus = converted_catalogue.add_buses_list();
 
-		new_converted_bus->set_is_looped(original_bus.get()->is_looped);
-		new_converted_bus->set_name(original_bus.get()->name);
-		new_converted_bus->set_id(original_bus.get()->id);
+		new_converted_bus->set_is_looped(original_bus.is_looped);
+		new_converted_bus->set_name(original_bus.name);
+		new_converted_bus->set_id(original_bus.id);
 
-		size_t count = (original_bus.get()->is_looped) ? original_bus.get()->stops.size() : original_bus.get()->stops.size() / 2 + 1; 
+		size_t count = (original_bus.is_looped) ? original_bus.stops.size() : original_bus.stops.size() / 2 + 1; 
 		for (size_t i = 0; i< count; ++i){
-			new_converted_bus->add_stops(original_bus.get()->stops.at(i).get()->id);
+			new_converted_bus->add_stops(original_bus.stops.at(i));
 		}
+
+		new_converted_bus->set_route_length(original_bus.stats.route_length);
+		new_converted_bus->set_curvature(original_bus.stats.curvature);
+		new_converted_bus->set_stop_count(original_bus.stats.stop_count);
+		new_converted_bus->set_unique_stop_count(original_bus.stats.unique_stop_count);
 	}
 
-	for (auto& [pair, distance] : transport_catalogue.GetStopsPairToDistance()){
+	for (const auto& [stops_pair, distance] : transport_catalogue.GetDistances()){
 		transport_proto::Pair* new_converted_pair = converted_catalogue.add_distances();
+		const auto [id_from, id_to] = UnpackStopsPair(stops_pair);
 
-		new_converted_pair->set_id_from(pair.first.get()->id);
-		new_converted_pair->set_id_to(pair.second.get()->id);
+		new_converted_pair->set_id_from(id_from);
+		new_converted_pair->set_id_to(id_to);
 		new_converted_pair->set_distance(distance);
 	}
 
 	return converted_catalogue;
 }
 
-std::string Serialization::GetStopNameById_(transport_proto::TransportCatalogue& converted_catalogue, int id){
-	for (int i = 0; i < converted_catalogue.stops_list_size(); ++i){
-		const transport_proto::Stop& converted_stop = converted_catalogue.stops_list(i);
-		if (converted_stop.id() == id)
-			return converted_stop.name();
-	}
-	return "";
-}
-
+// Номера остановок и маршрутов в базе плотные и совпадают с их местами
+// в списках, поэтому каталог восстанавливается напрямую по номерам
 TransportCatalogue Serialization::ConvertProtoTransportCatalogue_(transport_proto::TransportCatalogue& converted_catalogue){
 	TransportCatalogue transport_catalogue;
+	transport_catalogue.Reserve(converted_catalogue.stops_list_size(), converted_catalogue.buses_list_size());
 
 	for (int i = 0; i < converted_catalogue.stops_list_size(); ++i){
 		const transport_proto::Stop& converted_stop = converted_catalogue.stops_list(i);
-		transport_catalogue.AddStop({"Stop", converted_stop.name(),
-			DoubleToString(converted_stop.coord_x()), 
-			DoubleToString(converted_stop.coord_y())});
+		if (converted_stop.id() != static_cast<uint32_t>(i))
+			throw std::runtime_error("Stops in the base are not ordered by id");
+		transport_catalogue.AddStop(converted_stop.name(), {converted_stop.coord_x(), converted_stop.coord_y()});
 	}
 
+	std::vector<StopId> stops;
 	for (int i = 0; i < converted_catalogue.buses_list_size(); ++i){
 		const transport_proto::Bus& converted_bus = converted_catalogue.buses_list(i);
-
-		std::vector<std::string> stops;
-		stops.push_back("Bus");
-		stops.push_back(converted_bus.name());
-		for (int j=0; j<converted_bus.stops_size(); ++j){
-			stops.push_back(GetStopNameById_(converted_catalogue, converted_bus.stops(j)));
-		}
-		transport_catalogue.AddBus(stops, converted_bus.is_looped());
+		if (converted_bus.id() != static_cast<uint32_t>(i))
+			throw std::runtime_error("Buses in the base are not ordered by id");
+
+		stops.assign(converted_bus.stops().begin(), converted_bus.stops().end());
+		transport_catalogue.AddBus(converted_bus.name(), stops, converted_bus.is_looped());
+
+		BusStats stats;
+		stats.route_length = converted_bus.route_length();
+		stats.curvature = converted_bus.curvature();
+		stats.stop_count = converted_bus.stop_count();
+		stats.unique_stop_count = converted_bus.unique_stop_count();
+		transport_catalogue.SetBusStats(i, stats);
 	}
 
-	for (int i = 0; i < converted_catalogue.distances_size(); ++i){
-		transport_catalogue.SetDistancesBetweenCurrentStopAndAnother(
-			GetStopNameById_(converted_catalogue, converted_catalogue.distances(i).id_from()),
-			GetStopNameById_(converted_catalogue, converted_catalogue.distances(i).id_to()),
-			converted_catalogue.distances(i).distance()
-		);
-		
+	for (const transport_proto::Pair& converted_pair : converted_catalogue.distances()){
+		transport_catalogue.SetDistance(converted_pair.id_from(), converted_pair.id_to(), converted_pair.distance());
 	}
 
 	return transport_catalogue;
@@ -231,6 +598,10 @@ transport_proto::RouteSettings Serialization::ConvertRouteSettings_(RouteSetting
 
 	converted_settings.set_bus_wait_time(route_settings.bus_wait_time);
 	converted_settings.set_bus_velocity(route_settings.bus_velocity);
+	converted_settings.set_router_type(static_cast<uint32_t>(route_settings.router_type));
+	converted_settings.set_route_cache_size(route_settings.route_cache_size);
+	converted_settings.set_route_rows_limit(route_settings.route_rows_limit);
+	converted_settings.set_graph_model(static_cast<uint32_t>(route_settings.graph_model));
 
 	return converted_settings;
 }
@@ -240,111 +611,212 @@ transport_proto::Graph Serialization::ConvertGraph_(TransportRouter& transport_r
 
 	std::shared_ptr<graph::DirectedWeightedGraph<double>> orig_graph = transport_router.GetGraph();
 
-	auto& edges = orig_graph.get()->GetEdges();
-	for (size_t i = 0; i < edges.size(); ++i){
-		transport_proto::Edge* new_edge = converted_graph.add_edges();
-	
-		new_edge->set_from(edges.at(i).from);
-		new_edge->set_to(edges.at(i).to);
-		new_edge->set_weight(edges.at(i).weight);
-	}
+	converted_graph.set_vertex_count(orig_graph.get()->GetVertexCount());
 
-	auto& incidence_lists = orig_graph.get()->GetIncidenceLists();
-	for (size_t i = 0; i < incidence_lists.size(); ++i){
-		transport_proto::IncidenceList* new_list = converted_graph.add_incidence_lists();
-		for (size_t j = 0; j < incidence_lists.at(i).size(); ++j){
-			new_list->add_incidence_list(incidence_lists.at(i).at(j));
-		}
+	const size_t edge_count = orig_graph.get()->GetEdgeCount();
+	converted_graph.mutable_from_deltas()->Reserve(edge_count);
+	converted_graph.mutable_to()->Reserve(edge_count);
+	converted_graph.mutable_weights()->Reserve(edge_count);
+	int64_t prev_from = 0;
+	for (graph::EdgeId i = 0; i < edge_count; ++i){
+		const graph::Edge<double>& edge = orig_graph.get()->GetEdge(i);
+
+		converted_graph.add_from_deltas(static_cast<int64_t>(edge.from) - prev_from);
+		converted_graph.add_to(edge.to);
+		converted_graph.add_weights(edge.weight);
+		prev_from = edge.from;
 	}
 
 	return converted_graph;
 }
 
-transport_proto::Router Serialization::ConvertRouter_(TransportRouter& transport_router){
-	transport_proto::Router converted_router;
+transport_proto::EdgesInfo Serialization::ConvertEdgesInfo_(TransportRouter& transport_router){
+	transport_proto::EdgesInfo converted_edges_info;
+
+	for (const EdgeInfo& edge_info : transport_router.GetEdgesInfo()){
+		converted_edges_info.add_type(static_cast<uint32_t>(edge_info.type));
+		converted_edges_info.add_stop_id(edge_info.stop_id);
+		converted_edges_info.add_bus_id(edge_info.bus_id);
+		converted_edges_info.add_span_count(edge_info.span_count);
+	}
+
+	return converted_edges_info;
+}
+
+transport_proto::RouterBlock Serialization::ConvertRouterBlock_(const AllPairsRouter::RoutesInternalData& routes_internal_data,
+	graph::VertexId first_row, size_t rows_count){
+	transport_proto::RouterBlock converted_block;
+	converted_block.set_first_row(first_row);
+	converted_block.set_rows_count(rows_count);
+
+	switch (serialization_settings_.router_encoding) {
+	case RouterEncoding::RAW:
+		// Строки пишутся одним блоком байт, как они лежат в памяти
+		converted_block.set_cells(reinterpret_cast<const char*>(routes_internal_data.GetRow(first_row)),
+			rows_count * routes_internal_data.GetVertexCount() * sizeof(AllPairsRouter::RouteInternalData));
+		break;
+	case RouterEncoding::SPARSE:
+		*converted_block.mutable_sparse_routes() = ConvertSparseRoutes_(routes_internal_data, first_row, rows_count);
+		break;
+	case RouterEncoding::SPARSE_GZIP: {
+		std::string compressed;
+		{
+			google::protobuf::io::StringOutputStream string_stream(&compressed);
+			google::protobuf::io::GzipOutputStream gzip_stream(&string_stream);
+			if (!ConvertSparseRoutes_(routes_internal_data, first_row, rows_count).SerializeToZeroCopyStream(&gzip_stream)
+				|| !gzip_stream.Close())
+				throw std::runtime_error("Failed to compress router matrix");
+		}
+		converted_block.set_compressed_sparse_routes(std::move(compressed));
+		break;
+	}
+	}
 
-	std::shared_ptr<graph::Router<double>> orig_router = transport_router.GetRouter();
-	auto& routes_internal_data = orig_router.get()->GetInternalData();
-	for (size_t i = 0; i < routes_internal_data.size(); ++i){
-		transport_proto::RouteInternalDataArr* new_array = converted_router.add_data();
-		for (size_t j = 0; j < routes_internal_data.at(i).size(); ++j){
-			transport_proto::RouteInternalData* new_struct = new_array->add_data();
-
-			if (routes_internal_data.at(i).at(j).has_value()){
-				new_struct->set_has_value(1);
-				new_struct->set_weight(routes_internal_data.at(i).at(j).value().weight);
-				if (routes_internal_data.at(i).at(j).value().prev_edge.has_value()){
-					new_struct->mutable_edge_id()->set_has_value(1);
-					new_struct->mutable_edge_id()->set_edge_id(routes_internal_data.at(i).at(j).value().prev_edge.value());
-				} else {
-					new_struct->mutable_edge_id()->set_has_value(0);
-				}
-			} else {
-				new_struct->set_has_value(0);
+	return converted_block;
+}
+
+transport_proto::SparseRoutes Serialization::ConvertSparseRoutes_(const AllPairsRouter::RoutesInternalData& routes_internal_data,
+	graph::VertexId first_row, size_t rows_count){
+	transport_proto::SparseRoutes sparse_routes;
+	const size_t vertex_count = routes_internal_data.GetVertexCount();
+
+	for (graph::VertexId from = first_row; from < first_row + rows_count; ++from){
+		const AllPairsRouter::RouteInternalData* row = routes_internal_data.GetRow(from);
+		int64_t prev_value = 0;
+
+		for (size_t vertex = 0; vertex < vertex_count;){
+			const size_t unreachable_begin = vertex;
+			while (vertex < vertex_count && row[vertex].prev_edge == graph::UNREACHABLE)
+				++vertex;
+			sparse_routes.add_runs(vertex - unreachable_begin);
+			if (vertex == vertex_count)
+				break;
+
+			const size_t reachable_begin = vertex;
+			for (; vertex < vertex_count && row[vertex].prev_edge != graph::UNREACHABLE; ++vertex){
+				const int64_t value = row[vertex].prev_edge == graph::NO_PREV_EDGE ? int64_t{ -1 } : static_cast<int64_t>(row[vertex].prev_edge);
+				sparse_routes.add_prev_edge_deltas(value - prev_value);
+				prev_value = value;
 			}
+			sparse_routes.add_runs(vertex - reachable_begin);
 		}
 	}
 
-	return converted_router;
+	return sparse_routes;
 }
 
 void Serialization::ConvertProtoRouteSettings_(RouteSettings& route_settings, 
 	transport_proto::RouteSettings converted_settings){
 	route_settings.bus_wait_time = converted_settings.bus_wait_time();
 	route_settings.bus_velocity = converted_settings.bus_velocity();
+	route_settings.router_type = static_cast<RouterType>(converted_settings.router_type());
+	route_settings.route_cache_size = converted_settings.route_cache_size();
+	route_settings.route_rows_limit = converted_settings.route_rows_limit();
+	route_settings.graph_model = static_cast<GraphModel>(converted_settings.graph_model());
 }
 
 void Serialization::ConvertProtoGraph_(transport_proto::Graph& converted_graph, 
 	std::shared_ptr<graph::DirectedWeightedGraph<double>> graph){
 	
-	auto& edges = graph.get()->GetEdges();
-	for (int i = 0; i < converted_graph.edges_size(); ++i){
+	const int edge_count = converted_graph.from_deltas_size();
+	if (converted_graph.to_size() != edge_count || converted_graph.weights_size() != edge_count)
+		throw std::runtime_error("Graph in the base is corrupted");
+
+	std::vector<graph::Edge<double>> edges;
+	edges.reserve(edge_count);
+	int64_t from = 0;
+	for (int i = 0; i < edge_count; ++i){
+		from += converted_graph.from_deltas(i);
+		if (from < 0)
+			throw std::runtime_error("Graph in the base is corrupted");
 		edges.push_back({
-			converted_graph.edges(i).from(),
-			converted_graph.edges(i).to(),
-			converted_graph.edges(i).weight()
+			static_cast<graph::VertexId>(from),
+			converted_graph.to(i),
+			converted_graph.weights(i)
 		});
 	}
 
-	auto& incidence_lists = graph.get()->GetIncidenceLists();
-	for (int i = 0; i < converted_graph.incidence_lists_size(); ++i){
-		std::vector<graph::EdgeId> new_list;
-		for (int j = 0; j < converted_graph.incidence_lists(i).incidence_list_size(); ++j){
-			new_list.push_back(converted_graph.incidence_lists(i).incidence_list(j));
+	// Списки инцидентности строятся конструктором за один проход
+	*graph = graph::DirectedWeightedGraph<double>(converted_graph.vertex_count(), std::move(edges));
+}
+
+void Serialization::ConvertProtoEdgesInfo_(transport_proto::EdgesInfo& converted_edges_info,
+	std::vector<EdgeInfo>& edges_info){
+	edges_info.clear();
+	edges_info.reserve(converted_edges_info.type_size());
+
+	for (int i = 0; i < converted_edges_info.type_size(); ++i){
+		edges_info.push_back({
+			static_cast<EdgeType>(converted_edges_info.type(i)),
+			converted_edges_info.stop_id(i),
+			converted_edges_info.bus_id(i),
+			static_cast<int>(converted_edges_info.span_count(i))
+		});
+	}
+}
+
+void Serialization::ConvertProtoRouterBlock_(const transport_proto::RouterBlock& converted_block, RouterEncoding encoding,
+	AllPairsRouter::RoutesInternalData& routes_internal_data){
+	const size_t first_row = converted_block.first_row();
+	const size_t rows_count = converted_block.rows_count();
+	if (first_row > routes_internal_data.GetRowsCount() || rows_count > routes_internal_data.GetRowsCount() - first_row)
+		throw std::runtime_error("Router matrix in the base is corrupted");
+
+	switch (encoding) {
+	case RouterEncoding::RAW:
+		if (converted_block.cells().size() != rows_count * routes_internal_data.GetVertexCount() * sizeof(AllPairsRouter::RouteInternalData)) {
+			throw std::runtime_error("Router matrix in the base is corrupted");
 		}
-		incidence_lists.push_back(new_list);
+		std::memcpy(routes_internal_data.GetRow(first_row), converted_block.cells().data(), converted_block.cells().size());
+		break;
+	case RouterEncoding::SPARSE:
+		ConvertProtoSparseRoutes_(converted_block.sparse_routes(), first_row, rows_count, routes_internal_data);
+		break;
+	case RouterEncoding::SPARSE_GZIP: {
+		transport_proto::SparseRoutes sparse_routes;
+		google::protobuf::io::ArrayInputStream array_stream(converted_block.compressed_sparse_routes().data(),
+			converted_block.compressed_sparse_routes().size());
+		google::protobuf::io::GzipInputStream gzip_stream(&array_stream);
+		if (!sparse_routes.ParseFromZeroCopyStream(&gzip_stream))
+			throw std::runtime_error("Router matrix in the base is corrupted");
+		ConvertProtoSparseRoutes_(sparse_routes, first_row, rows_count, routes_internal_data);
+		break;
+	}
 	}
 }
 
-void Serialization::ConvertProtoRouter_(transport_proto::Router& converted_router,
-	std::shared_ptr<graph::Router<double>> router){
-	auto& routes_internal_data = router.get()->GetInternalData();
-
-	for (int i = 0; i < converted_router.data_size(); ++i){
-		std::vector<std::optional<graph::Router<double>::RouteInternalData>> new_arr;
-
-		for (int j = 0; j < converted_router.data(i).data_size(); ++j){
-			
-			if (converted_router.data(i).data(j).has_value()){
-				graph::Router<double>::RouteInternalData str;
-				if (converted_router.data(i).data(j).edge_id().has_value()){
-					str = {
-						converted_router.data(i).data(j).weight(),
-						converted_router.data(i).data(j).edge_id().edge_id()
-					};
-				} else {
-					str = {
-						converted_router.data(i).data(j).weight(),
-						std::nullopt
-					};
-				}
-				new_arr.push_back(str);
-			} else {
-				new_arr.push_back(std::nullopt);
+void Serialization::ConvertProtoSparseRoutes_(const transport_proto::SparseRoutes& sparse_routes,
+	graph::VertexId first_row, size_t rows_count, AllPairsRouter::RoutesInternalData& routes_internal_data){
+	const size_t vertex_count = routes_internal_data.GetVertexCount();
+	int runs_index = 0;
+	int deltas_index = 0;
+
+	auto next_run = [&](size_t vertex) -> size_t {
+		if (runs_index == sparse_routes.runs_size() || sparse_routes.runs(runs_index) > vertex_count - vertex)
+			throw std::runtime_error("Router matrix in the base is corrupted");
+		return sparse_routes.runs(runs_index++);
+	};
+
+	for (graph::VertexId from = first_row; from < first_row + rows_count; ++from){
+		AllPairsRouter::RouteInternalData* row = routes_internal_data.GetRow(from);
+		int64_t prev_value = 0;
+
+		for (size_t vertex = 0; vertex < vertex_count;){
+			// Ячейки после Resize уже недостижимы
+			vertex += next_run(vertex);
+			if (vertex == vertex_count)
+				break;
+
+			const size_t reachable_end = vertex + next_run(vertex);
+			if (reachable_end - vertex > static_cast<size_t>(sparse_routes.prev_edge_deltas_size() - deltas_index))
+				throw std::runtime_error("Router matrix in the base is corrupted");
+			for (; vertex < reachable_end; ++vertex){
+				prev_value += sparse_routes.prev_edge_deltas(deltas_index++);
+				row[vertex].prev_edge = prev_value == -1 ? graph::NO_PREV_EDGE : static_cast<graph::CompactEdgeId>(prev_value);
 			}
-
 		}
-
-		routes_internal_data.push_back(new_arr);
 	}
+
+	if (runs_index != sparse_routes.runs_size() || deltas_index != sparse_routes.prev_edge_deltas_size())
+		throw std::runtime_error("Router matrix in the base is corrupted");
 }
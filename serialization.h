@@ -2,17 +2,29 @@
 
 #include <filesystem>
 #include <fstream>  
+#include <future>
 #include <string>
 #include <optional>
 #include <vector>
 #include <memory>
 #include <variant>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
 
 #include "transport_catalogue.pb.h"
 #include "map_renderer.pb.h"
 #include "svg.pb.h"
 #include "transport_router.pb.h"
 #include "graph.pb.h"
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/io/gzip_stream.h>
+#include "mapped_base.h"
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "transport_router.h"
@@ -21,8 +33,35 @@
 
 using Path = std::filesystem::path;
 
+// PROTOBUF - база в одном сообщении protobuf, MAPPED - двоичный формат,
+// который читается через отображение файла в память (см. mapped_base.h)
+enum class BaseFormat {
+	PROTOBUF,
+	MAPPED
+};
+
+// Запись матрицы маршрутов в базе protobuf: RAW - все ячейки подряд
+// как в памяти, SPARSE - только достижимые ячейки с разностями номеров
+// ребер, SPARSE_GZIP - то же, сжатое gzip
+enum class RouterEncoding {
+	RAW,
+	SPARSE,
+	SPARSE_GZIP
+};
+
 struct SerializationSettings{
 	Path file_name;
+	// Формат записываемой базы. При чтении формат определяется по заголовку файла
+	BaseFormat format = BaseFormat::PROTOBUF;
+	// Запись матрицы маршрутов. При чтении берется из самой базы
+	RouterEncoding router_encoding = RouterEncoding::SPARSE;
+};
+
+// Части базы, которые нужно загрузить. Каталог загружается всегда
+struct BaseSections{
+	bool render_settings = true;
+	// Настройки маршрутизации, граф, сведения о ребрах и движок
+	bool routing = true;
 };
 
 class Serialization{
@@ -31,16 +70,37 @@ public:
 
 	void Serialize(TransportCatalogue& transport_catalogue, MapRenderer& map_renderer, TransportRouter& transport_router);
 
-	void Deserialize(TransportCatalogue& transport_catalogue, MapRenderer& map_renderer, TransportRouter& transport_router);
+	void Deserialize(TransportCatalogue& transport_catalogue, MapRenderer& map_renderer, TransportRouter& transport_router,
+		const BaseSections& sections = {});
 
 	void SetSerializationSettings(SerializationSettings serialization_settings);
 
 private:
 	SerializationSettings serialization_settings_;
 
+	// Число строк матрицы маршрутов в одном блоке базы protobuf
+	static constexpr size_t ROUTER_BLOCK_ROWS = 256;
+
+	void SerializeMapped_(std::ofstream& out, TransportCatalogue& transport_catalogue,
+		MapRenderer& map_renderer, TransportRouter& transport_router);
+	void DeserializeMapped_(std::shared_ptr<mapped_base::MappedFile> mapped_file, TransportCatalogue& transport_catalogue,
+		MapRenderer& map_renderer, TransportRouter& transport_router, const BaseSections& sections);
+	// Поле Container с сообщением: тег, длина и само сообщение
+	static void WriteSection_(google::protobuf::io::CodedOutputStream& output, int field_number,
+		const google::protobuf::MessageLite& message);
+	// Заголовок матрицы маршрутов и следом ее строки блоками по ROUTER_BLOCK_ROWS
+	void WriteRouter_(google::protobuf::io::CodedOutputStream& output,
+		const AllPairsRouter::RoutesInternalData& routes_internal_data);
+	// Потоковое чтение контейнера protobuf: секции переводятся по одной,
+	// ненужные поля пропускаются без разбора
+	void DeserializeProtobuf_(const mapped_base::MappedFile& mapped_file, TransportCatalogue& transport_catalogue,
+		MapRenderer& map_renderer, TransportRouter& transport_router, const BaseSections& sections);
+	// Содержимое секции с проверкой ее наличия и размера элементов
+	std::pair<const char*, size_t> GetMappedSection_(const mapped_base::MappedFile& mapped_file,
+		mapped_base::SectionType type, size_t element_size);
+
 	transport_proto::TransportCatalogue ConvertTransportCatalogue_(TransportCatalogue& transport_catalogue);
 
-	std::string GetStopNameById_(transport_proto::TransportCatalogue& converted_catalogue, int id);
 	TransportCatalogue ConvertProtoTransportCatalogue_(transport_proto::TransportCatalogue& converted_catalogue);
 
 
@@ -55,12 +115,20 @@ private:
 
 	transport_proto::RouteSettings ConvertRouteSettings_(RouteSettings& route_settings);
 	transport_proto::Graph ConvertGraph_(TransportRouter& transport_router);
-	transport_proto::Router ConvertRouter_(TransportRouter& transport_router);
+	transport_proto::EdgesInfo ConvertEdgesInfo_(TransportRouter& transport_router);
+	transport_proto::RouterBlock ConvertRouterBlock_(const AllPairsRouter::RoutesInternalData& routes_internal_data,
+		graph::VertexId first_row, size_t rows_count);
+	transport_proto::SparseRoutes ConvertSparseRoutes_(const AllPairsRouter::RoutesInternalData& routes_internal_data,
+		graph::VertexId first_row, size_t rows_count);
 
 	void ConvertProtoRouteSettings_(RouteSettings& route_settings, 
 		transport_proto::RouteSettings converted_settings);
 	void ConvertProtoGraph_(transport_proto::Graph& converted_graph, 
 		std::shared_ptr<graph::DirectedWeightedGraph<double>> graph);
-	void ConvertProtoRouter_(transport_proto::Router& converted_router,
-		std::shared_ptr<graph::Router<double>> router);
+	void ConvertProtoEdgesInfo_(transport_proto::EdgesInfo& converted_edges_info,
+		std::vector<EdgeInfo>& edges_info);
+	void ConvertProtoRouterBlock_(const transport_proto::RouterBlock& converted_block, RouterEncoding encoding,
+		AllPairsRouter::RoutesInternalData& routes_internal_data);
+	void ConvertProtoSparseRoutes_(const transport_proto::SparseRoutes& sparse_routes,
+		graph::VertexId first_row, size_t rows_count, AllPairsRouter::RoutesInternalData& routes_internal_data);
 };
\ No newline at end of file
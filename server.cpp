@@ -0,0 +1,220 @@
+#include "server.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "json_builder.h"
+
+namespace {
+	using namespace std::literals;
+
+	bool IsBlank(std::string_view line) {
+		return line.find_first_not_of(" \t\r"sv) == std::string_view::npos;
+	}
+
+	// Следующий пакет или nullopt, если вход закончился. Бросает
+	// std::runtime_error, если разделение пакетов нарушено
+	std::optional<std::string> ReadBatch(std::istream& input, Framing framing) {
+		std::string line;
+		while (std::getline(input, line) && IsBlank(line)) {
+		}
+		if (!input) {
+			return std::nullopt;
+		}
+		if (framing == Framing::NDJSON) {
+			return line;
+		}
+
+		// Строка с длиной пакета, возможно с \r в конце
+		const size_t length_end = line.find_last_not_of(" \t\r"sv) + 1;
+		size_t length = 0;
+		const auto [end, error] = std::from_chars(line.data(), line.data() + length_end, length);
+		if (error != std::errc{} || end != line.data() + length_end) {
+			throw std::runtime_error("Invalid batch length '"s + line + "'"s);
+		}
+		std::string batch(length, '\0');
+		if (!input.read(batch.data(), static_cast<std::streamsize>(length))) {
+			throw std::runtime_error("Batch is shorter than its length"s);
+		}
+		return batch;
+	}
+
+	// Ответ собирается целиком до отправки: для LENGTH_PREFIXED нужна его
+	// длина, а при ошибке посреди пакета клиент не получит обрывок
+	std::string AnswerBatch(TransportManagers& transport_managers, std::string_view batch, json::Format output_format) {
+		const json::Dict requests = json::Load(batch).GetRoot().AsDict();
+		std::ostringstream answer;
+		PrintCatatlog(transport_managers, requests.at("stat_requests"s).AsArray(), answer, output_format);
+		return std::move(answer).str();
+	}
+
+	std::string MakeErrorAnswer(std::string_view message, json::Format output_format) {
+		std::ostringstream answer;
+		json::Writer writer(answer, output_format);
+		json::TypedBuilder(writer).StartDict()
+			.Key("error_message"sv).Value(std::string(message))
+			.EndDict();
+		return std::move(answer).str();
+	}
+
+	void WriteAnswer(std::ostream& output, const std::string& answer, Framing framing) {
+		if (framing == Framing::LENGTH_PREFIXED) {
+			output << answer.size() << '\n';
+		}
+		output << answer;
+		if (framing == Framing::NDJSON) {
+			output << '\n';
+		}
+		output.flush();
+	}
+}  // namespace
+
+void ServeBatches(TransportManagers& transport_managers, std::istream& input, std::ostream& output,
+	const ServerSettings& settings) {
+	// Ответ NDJSON обязан уместиться в одну строку
+	const json::Format output_format = settings.framing == Framing::NDJSON ? json::Format::COMPACT : settings.output_format;
+
+	while (output) {
+		std::optional<std::string> batch;
+		try {
+			batch = ReadBatch(input, settings.framing);
+		} catch (const std::exception& error) {
+			// Граница следующего пакета неизвестна, дальше читать нельзя
+			WriteAnswer(output, MakeErrorAnswer(error.what(), output_format), settings.framing);
+			return;
+		}
+		if (!batch) {
+			return;
+		}
+
+		std::string answer;
+		try {
+			answer = AnswerBatch(transport_managers, *batch, output_format);
+		} catch (const std::exception& error) {
+			answer = MakeErrorAnswer(error.what(), output_format);
+		}
+		WriteAnswer(output, answer, settings.framing);
+	}
+}
+
+void ServeUnixSocket(TransportManagers& transport_managers, const std::string& socket_path,
+	const ServerSettings& settings) {
+	sockaddr_un address{};
+	if (socket_path.size() >= sizeof(address.sun_path)) {
+		throw std::runtime_error("Socket path is too long: "s + socket_path);
+	}
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+	const int server_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server_fd < 0) {
+		throw std::runtime_error("Failed to create socket: "s + std::strerror(errno));
+	}
+
+	// Сокет, оставшийся от прошлого запуска, мешает bind. Другие файлы не трогаем
+	struct stat socket_stat;
+	if (::stat(socket_path.c_str(), &socket_stat) == 0 && S_ISSOCK(socket_stat.st_mode)) {
+		::unlink(socket_path.c_str());
+	}
+	if (::bind(server_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+		|| ::listen(server_fd, SOMAXCONN) != 0) {
+		const std::string error = std::strerror(errno);
+		::close(server_fd);
+		throw std::runtime_error("Failed to listen on "s + socket_path + ": "s + error);
+	}
+
+	while (true) {
+		const int client_fd = ::accept(server_fd, nullptr, nullptr);
+		if (client_fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			const std::string error = std::strerror(errno);
+			::close(server_fd);
+			throw std::runtime_error("Failed to accept connection: "s + error);
+		}
+
+		{
+			SocketStreamBuf buffer(client_fd);
+			std::istream input(&buffer);
+			std::ostream output(&buffer);
+			ServeBatches(transport_managers, input, output, settings);
+		}
+		::close(client_fd);
+	}
+}
+
+SocketStreamBuf::SocketStreamBuf(int socket_fd)
+	: socket_fd_(socket_fd)
+	, input_buffer_(BUFFER_SIZE)
+	, output_buffer_(BUFFER_SIZE) {
+	setg(input_buffer_.data(), input_buffer_.data(), input_buffer_.data());
+	setp(output_buffer_.data(), output_buffer_.data() + output_buffer_.size());
+}
+
+SocketStreamBuf::~SocketStreamBuf() {
+	Flush_();
+}
+
+SocketStreamBuf::int_type SocketStreamBuf::underflow() {
+	if (gptr() < egptr()) {
+		return traits_type::to_int_type(*gptr());
+	}
+
+	ssize_t received = 0;
+	do {
+		received = ::recv(socket_fd_, input_buffer_.data(), input_buffer_.size(), 0);
+	} while (received < 0 && errno == EINTR);
+	if (received <= 0) {
+		return traits_type::eof();
+	}
+
+	setg(input_buffer_.data(), input_buffer_.data(), input_buffer_.data() + received);
+	return traits_type::to_int_type(*gptr());
+}
+
+SocketStreamBuf::int_type SocketStreamBuf::overflow(int_type character) {
+	if (!Flush_()) {
+		return traits_type::eof();
+	}
+	if (!traits_type::eq_int_type(character, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(character);
+		pbump(1);
+	}
+	return traits_type::not_eof(character);
+}
+
+int SocketStreamBuf::sync() {
+	return Flush_() ? 0 : -1;
+}
+
+bool SocketStreamBuf::Flush_() {
+	const char* data = pbase();
+	size_t left = pptr() - pbase();
+	setp(output_buffer_.data(), output_buffer_.data() + output_buffer_.size());
+
+	while (left > 0) {
+		// MSG_NOSIGNAL: отключившийся клиент дает ошибку, а не SIGPIPE
+		const ssize_t sent = ::send(socket_fd_, data, left, MSG_NOSIGNAL);
+		if (sent < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += sent;
+		left -= sent;
+	}
+	return true;
+}
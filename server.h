@@ -0,0 +1,61 @@
+#pragma once
+
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "json.h"
+#include "json_reader.h"
+
+// Режим сервера: база загружается один раз, после чего на каждый
+// пакет запросов {"stat_requests": [...]} выдается ответ того же вида,
+// что и в process_requests. Пакеты разделяются одним из способов:
+// NDJSON - по пакету в строке, ответ тоже в одну строку (всегда компактный);
+// LENGTH_PREFIXED - строка с длиной пакета в байтах, затем сам пакет,
+// ответ передается так же
+enum class Framing {
+	NDJSON,
+	LENGTH_PREFIXED
+};
+
+struct ServerSettings {
+	Framing framing = Framing::NDJSON;
+	json::Format output_format = json::Format::PRETTY;
+};
+
+// Отвечает на пакеты из input, пока он не закончится. Ошибка в пакете
+// не прерывает работу: вместо ответа выдается {"error_message": ...}
+void ServeBatches(TransportManagers& transport_managers, std::istream& input, std::ostream& output,
+	const ServerSettings& settings);
+
+// Принимает подключения к сокету Unix по пути socket_path по одному
+// и обслуживает каждое как ServeBatches. Возвращает управление только
+// при ошибке сокета, бросая std::runtime_error
+void ServeUnixSocket(TransportManagers& transport_managers, const std::string& socket_path,
+	const ServerSettings& settings);
+
+// Буфер потока поверх подключенного сокета
+class SocketStreamBuf : public std::streambuf {
+public:
+	explicit SocketStreamBuf(int socket_fd);
+	~SocketStreamBuf() override;
+
+	SocketStreamBuf(const SocketStreamBuf&) = delete;
+	SocketStreamBuf& operator=(const SocketStreamBuf&) = delete;
+
+protected:
+	int_type underflow() override;
+	int_type overflow(int_type character) override;
+	int sync() override;
+
+private:
+	static constexpr size_t BUFFER_SIZE = 1 << 16;
+
+	int socket_fd_;
+	std::vector<char> input_buffer_;
+	std::vector<char> output_buffer_;
+
+	// Отправляет накопленный вывод, false при ошибке сокета
+	bool Flush_();
+};
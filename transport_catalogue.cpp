@@ -1,4 +1,6 @@
 #include <iostream>
+#include <algorithm>
+#include <numeric>
 
 #include "transport_catalogue.h"
 
@@ -6,156 +8,173 @@ using namespace std;
 
 // vector<string>& words - это результат работы
 // функции GetTypeNameAndContent.
-// Функция создает указатели на новую останоку
-// в мэпе остановок и на новый сет в словаре stops_to_buses_,
-// если таковых не сущетсвует.
 void TransportCatalogue::AddStop(const vector<string>& words) {
-	string stop_name = words.at(1);
+	AddStop(words.at(1), { stod(words.at(2)), stod(words.at(3)) });
 
-	std::shared_ptr<Stop> current_stop;
-	if (!stops_.count(stop_name)) {
-		current_stop = GetPointerToStopByName_(stop_name);
-	} else {
-		current_stop = stops_.at(stop_name);
-	}
-	current_stop.get()->coord_x = stod(words.at(2));
-	current_stop.get()->coord_y = stod(words.at(3));
-
-	if (!stops_to_buses_.count(stop_name)) {
-		stops_to_buses_[stop_name] = make_shared<set<string>>();
+	vector<pair<string, int>> distances;
+	pair<int, string> distance_and_name;
+	for (size_t i = 4; i < words.size(); ++i) {
+		ReadDistanceAndStopNameFromString_(distance_and_name, words.at(i));
+		distances.push_back({ distance_and_name.second, distance_and_name.first });
 	}
-
-	SetDistancesBetweenCurrentStopAndOtherOnes_(current_stop, words);
+	AddDistances(words.at(1), distances);
 }
 
 // vector<string>& words - это результат работы
 // функции GetTypeNameAndContent.
 // is_loop - это return функции GetTypeNameAndContent.
-// Функция создает указатель на новый маршрут и
-// закидывает в его дек остановок указатели на
-// остановки.
-// Если добавляемая остановка не существует в 
-// мэпе остановок, то сперва создается указатель на нее,
-// и он попадает в мэпы оставнок и stops_to_buses_,
-// а потом уже в дек маршрута.
 void TransportCatalogue::AddBus(const vector<string>& words, bool is_loop) {
-	size_t words_index = 2;
-	string stop_name;
-	string bus_name = words[1];
-	std::shared_ptr<Bus> bus = make_shared<Bus>();
-
-	bus.get()->name = bus_name;
-	bus.get()->is_looped = is_loop;
-	bus.get()->id = buses_count_++;
-	for (; words_index < words.size(); ++words_index) {
-		stop_name = words.at(words_index);
-		if (!stops_.count(stop_name)) {
-			GetPointerToStopByName_(stop_name);
-		}
-		stops_[stop_name].get()->buses.insert(bus_name);
-		bus.get()->stops.push_back(stops_[stop_name]);
-
-		if (!stops_to_buses_.count(stop_name)) {
-			stops_to_buses_[stop_name] = make_shared<set<string>>();
-		}
-		stops_to_buses_[stop_name].get()->insert(bus.get()->name);
-	}
+	AddBus(words.at(1), vector<string>(words.begin() + 2, words.end()), is_loop);
+}
 
-	// если в запросе на обновление каталога " - " - это сепаратор
-	// (GetTypeNameAndContent вернет false),
-	// то нужно отдельно прописать, что автобус после конечной поедет обратно.
-	if (!is_loop) {
-		words_index -= 2;
-		for (; words_index >= 2; --words_index) {
-			stop_name = words[words_index];
-			bus.get()->stops.push_back(stops_[stop_name]);
-		}
-	}
+// Функция создает новую остановку в хранилище
+// остановок, если таковой не сущетсвует.
+void TransportCatalogue::AddStop(const string& name, geo::Coordinates coordinates) {
+	Stop& stop = stops_[GetOrAddStop_(name)];
 
-	buses_[bus.get()->name] = bus;
+	stop.coord_x = coordinates.lat;
+	stop.coord_y = coordinates.lng;
 }
 
-std::shared_ptr<Bus> TransportCatalogue::GetBus(const string& bus_name) const {
-	if (!buses_.count(bus_name)) {
-		return nullptr;
+// Функция создает новый маршрут и закидывает
+// в его вектор остановок номера остановок.
+// Если добавляемая остановка не существует в 
+// хранилище остановок, то сперва создается она,
+// а потом уже ее номер попадает в маршрут.
+void TransportCatalogue::AddBus(const string& name, const vector<string>& stop_names, bool is_roundtrip) {
+	vector<StopId> stop_ids;
+	stop_ids.reserve(stop_names.size());
+	for (const string& stop_name : stop_names) {
+		stop_ids.push_back(GetOrAddStop_(stop_name));
 	}
-	return buses_.at(bus_name);
+	AddBus(name, stop_ids, is_roundtrip);
 }
 
-int TransportCatalogue::GetDistanceBetweenTwoStops(const string& first_stop_name, const string& second_stop_name) {
-	std::shared_ptr<Stop> first_stop = GetPointerToStopByName_(first_stop_name);
-	std::shared_ptr<Stop> second_stop = GetPointerToStopByName_(second_stop_name);
+void TransportCatalogue::AddBus(const string& name, const vector<StopId>& stop_ids, bool is_roundtrip) {
+	Bus bus;
 
-	for (const auto& [left, right] : stops_pair_to_distance_) {
-		if (left.first.get() == first_stop.get() && left.second.get() == second_stop.get()) {
-			return right;
-		}
+	bus.name = name;
+	// Маршрут без остановок всегда считается кольцевым
+	bus.is_looped = is_roundtrip || stop_ids.empty();
+	bus.stops.reserve(bus.is_looped ? stop_ids.size() : 2 * stop_ids.size());
+	for (StopId stop_id : stop_ids) {
+		stops_.at(stop_id).buses.insert(bus.name);
+		bus.stops.push_back(stop_id);
 	}
-	for (const auto& [left, right] : stops_pair_to_distance_) {
-		if (left.second.get() == first_stop.get() && left.first.get() == second_stop.get()) {
-			return right;
+
+	// Некольцевой маршрут после конечной едет обратно
+	if (!bus.is_looped && bus.stops.size() > 1) {
+		for (size_t i = bus.stops.size() - 1; i > 0; --i) {
+			bus.stops.push_back(bus.stops[i - 1]);
 		}
 	}
-	return 0;
+
+	// Повторное добавление маршрута заменяет его, сохраняя номер
+	if (auto it = bus_name_to_id_.find(bus.name); it != bus_name_to_id_.end()) {
+		bus.id = it->second;
+		buses_[bus.id] = std::move(bus);
+		return;
+	}
+	bus.id = static_cast<BusId>(buses_.size());
+	bus_name_to_id_.emplace(bus.name, bus.id);
+	buses_.push_back(std::move(bus));
+	buses_sorted_by_name_.clear();
 }
 
-std::shared_ptr<std::set<std::string>> TransportCatalogue::GetStopToBuses(const string& stop_name) const {
-	if (!stops_to_buses_.count(stop_name)) {
-		return nullptr;
+// Записывает расстояния между остановкой и соседними в словарь distances_
+void TransportCatalogue::AddDistances(const string& stop_name, const vector<pair<string, int>>& distances) {
+	const StopId current_stop_id = GetOrAddStop_(stop_name);
+
+	for (const auto& [another_name, distance] : distances) {
+		const StopId another_stop_id = GetOrAddStop_(another_name);
+
+		distances_[PackStopsPair(current_stop_id, another_stop_id)] = distance;
 	}
-	return stops_to_buses_.at(stop_name);
 }
 
-size_t TransportCatalogue::GetStopsCount() {
-	return stops_count_;
+const Bus* TransportCatalogue::FindBus(const string& bus_name) const {
+	auto it = bus_name_to_id_.find(bus_name);
+	return it == bus_name_to_id_.end() ? nullptr : &buses_[it->second];
 }
 
-std::unordered_map<std::pair<std::shared_ptr<Stop>, std::shared_ptr<Stop>>, double, Hasher>& TransportCatalogue::GetStopsPairToDistance(){
-	return stops_pair_to_distance_;
+const Stop* TransportCatalogue::FindStop(const string& stop_name) const {
+	auto it = stop_name_to_id_.find(stop_name);
+	return it == stop_name_to_id_.end() ? nullptr : &stops_[it->second];
 }
 
-const std::map<std::string, std::shared_ptr<Stop>>& TransportCatalogue::GetStops() {
-	return stops_;
+const Stop& TransportCatalogue::GetStop(StopId stop_id) const {
+	return stops_.at(stop_id);
 }
 
-const std::map<std::string, std::shared_ptr<Bus>>& TransportCatalogue::GetBuses() {
-	return buses_;
+const Bus& TransportCatalogue::GetBus(BusId bus_id) const {
+	return buses_.at(bus_id);
 }
 
-const std::map<std::string, std::shared_ptr<std::set<std::string>>>& TransportCatalogue::GetStopsToBuses() {
-	return stops_to_buses_;
+int TransportCatalogue::GetDistanceBetweenTwoStops(const string& first_stop_name, const string& second_stop_name) {
+	return GetDistanceBetweenTwoStops(GetOrAddStop_(first_stop_name), GetOrAddStop_(second_stop_name));
 }
 
-const std::map<graph::VertexId, std::shared_ptr<Stop>>& TransportCatalogue::GetStopIdToStops() {
-	return stop_id_to_stops_;
+int TransportCatalogue::GetDistanceBetweenTwoStops(graph::VertexId first_stop_id, graph::VertexId second_stop_id) const {
+	if (auto it = distances_.find(PackStopsPair(first_stop_id, second_stop_id)); it != distances_.end()) {
+		return it->second;
+	}
+	if (auto it = distances_.find(PackStopsPair(second_stop_id, first_stop_id)); it != distances_.end()) {
+		return it->second;
+	}
+	return 0;
 }
 
-std::shared_ptr<Stop> TransportCatalogue::GetStopByName(const std::string& name){
-	return stops_.at(name);
+TransportCatalogue::StopsRange TransportCatalogue::GetStops() const {
+	return ranges::AsRange(stops_);
 }
 
-void TransportCatalogue::SetDistancesBetweenCurrentStopAndAnother(const std::string& current_stop, const std::string another_name, double distance) {
-	std::shared_ptr<Stop> left = GetPointerToStopByName_(current_stop);
-	std::shared_ptr<Stop> right = GetPointerToStopByName_(another_name);
-	stops_pair_to_distance_[{ left, right }] = distance;
+TransportCatalogue::BusesRange TransportCatalogue::GetBuses() const {
+	return ranges::AsRange(buses_);
 }
 
-// Записывает расстояния между текущей остановкой и всеми другими в словарь stops_pair_to_distance_
-// на основании разбитого на слова, которые лежат в векторе vector<string>& words, запроса.
-void TransportCatalogue::SetDistancesBetweenCurrentStopAndOtherOnes_(std::shared_ptr<Stop> current_stop, const vector<string>& words) {
-	std::shared_ptr<Stop> another_stop;
-	pair<int, string> distance_and_name;
+const std::vector<StopId>& TransportCatalogue::GetStopsSortedByName() const {
+	if (stops_sorted_by_name_.size() != stops_.size()) {
+		stops_sorted_by_name_.resize(stops_.size());
+		iota(stops_sorted_by_name_.begin(), stops_sorted_by_name_.end(), 0);
+		sort(stops_sorted_by_name_.begin(), stops_sorted_by_name_.end(), [this](StopId lhs, StopId rhs) {
+			return stops_[lhs].name < stops_[rhs].name;
+		});
+	}
+	return stops_sorted_by_name_;
+}
 
-	for (size_t i = 4; i < words.size(); ++i) {
-		ReadDistanceAndStopNameFromString_(distance_and_name, words.at(i));
+const std::vector<BusId>& TransportCatalogue::GetBusesSortedByName() const {
+	if (buses_sorted_by_name_.size() != buses_.size()) {
+		buses_sorted_by_name_.resize(buses_.size());
+		iota(buses_sorted_by_name_.begin(), buses_sorted_by_name_.end(), 0);
+		sort(buses_sorted_by_name_.begin(), buses_sorted_by_name_.end(), [this](BusId lhs, BusId rhs) {
+			return buses_[lhs].name < buses_[rhs].name;
+		});
+	}
+	return buses_sorted_by_name_;
+}
 
-		another_stop = GetPointerToStopByName_(distance_and_name.second);
-		another_stop.get()->name = distance_and_name.second;
+void TransportCatalogue::SetBusStats(BusId bus_id, const BusStats& stats) {
+	buses_.at(bus_id).stats = stats;
+}
 
-		if (!stops_pair_to_distance_.count({ current_stop, another_stop }) && !stops_pair_to_distance_.count({ another_stop, current_stop })) {
-			stops_pair_to_distance_[{ current_stop, another_stop }] = distance_and_name.first;
-		}
-	}
+size_t TransportCatalogue::GetStopsCount() const {
+	return stops_.size();
+}
+
+const std::unordered_map<StopsPairKey, double>& TransportCatalogue::GetDistances() const {
+	return distances_;
+}
+
+void TransportCatalogue::SetDistance(StopId from, StopId to, double distance) {
+	distances_[PackStopsPair(from, to)] = distance;
+}
+
+void TransportCatalogue::Reserve(size_t stops_count, size_t buses_count) {
+	stops_.reserve(stops_count);
+	stop_name_to_id_.reserve(stops_count);
+	buses_.reserve(buses_count);
+	bus_name_to_id_.reserve(buses_count);
 }
 
 // Вспомогательный метод для разбиения строки типа " 'расстояние'm to 'название остановки' " на pair<int, string>
@@ -180,14 +199,17 @@ void TransportCatalogue::ReadDistanceAndStopNameFromString_(pair<int, string>& d
 	distance_and_name.second = text;
 }
 
-// Берем указатель на остановку, если она существует,
-// или создаем новый, ставим ему имя и возвращаем.
-std::shared_ptr<Stop> TransportCatalogue::GetPointerToStopByName_(const string& stop_name) {
-	if (!stops_.count(stop_name)) {
-		stops_[stop_name] = make_shared<Stop>();
-		stops_[stop_name].get()->name = stop_name;
-		stops_[stop_name].get()->id = stops_count_;
-		stop_id_to_stops_[stops_count_++] = stops_[stop_name];
+// Берем номер остановки, если она существует,
+// или создаем новую, ставим ей имя и возвращаем ее номер.
+StopId TransportCatalogue::GetOrAddStop_(const string& stop_name) {
+	if (auto it = stop_name_to_id_.find(stop_name); it != stop_name_to_id_.end()) {
+		return it->second;
 	}
-	return stops_.at(stop_name);
+	const StopId stop_id = static_cast<StopId>(stops_.size());
+	Stop& stop = stops_.emplace_back();
+	stop.name = stop_name;
+	stop.id = stop_id;
+	stop_name_to_id_.emplace(stop_name, stop_id);
+	stops_sorted_by_name_.clear();
+	return stop_id;
 }
\ No newline at end of file
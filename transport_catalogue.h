@@ -1,82 +1,117 @@
 #pragma once
 
-#include <memory>
 #include <utility>
 #include <string>
-#include <deque>
 #include <unordered_map>
-#include <map>
 #include <set>
 #include <vector>
 #include <sstream>
 #include <iomanip>
+#include <cstdint>
 
 #include "domain.h"
+#include "geo.h"
+#include "ranges.h"
 
-struct Hasher {
-	size_t operator()(const std::pair<std::shared_ptr<Stop>, std::shared_ptr<Stop>>& stops) const {
-		std::hash<std::string> hasher;
-		size_t result = 0;
+// Ключ словаря расстояний: номера двух остановок, упакованные в одно число
+using StopsPairKey = std::uint64_t;
 
-		result += hasher(stops.first.get()->name) + 12 * hasher(stops.second.get()->name);
-		result += stops.first.get()->coord_x + 24 * stops.second.get()->coord_x;
-		result += stops.first.get()->coord_y + 48 * stops.second.get()->coord_y;
+inline StopsPairKey PackStopsPair(graph::VertexId from, graph::VertexId to) {
+	return (static_cast<StopsPairKey>(from) << 32) | static_cast<StopsPairKey>(to);
+}
 
-		return result;
-	}
-};
+inline std::pair<graph::VertexId, graph::VertexId> UnpackStopsPair(StopsPairKey key) {
+	return { static_cast<graph::VertexId>(key >> 32), static_cast<graph::VertexId>(key & 0xFFFFFFFFu) };
+}
 
 class TransportCatalogue {
 public:
+	using StopsRange = ranges::Range<std::vector<Stop>::const_iterator>;
+	using BusesRange = ranges::Range<std::vector<Bus>::const_iterator>;
+
 	TransportCatalogue() = default;
 
 	void AddStop(const std::vector<std::string>& words);
 
 	void AddBus(const std::vector<std::string>& words, bool is_loop);
 
-	std::shared_ptr<Bus> GetBus(const std::string& bus_name) const;
+	// Добавление остановки без расстояний до соседних
+	void AddStop(const std::string& name, geo::Coordinates coordinates);
+
+	// Добавление маршрута по названиям остановок. Некольцевой маршрут
+	// дополняется обратным путем
+	void AddBus(const std::string& name, const std::vector<std::string>& stop_names, bool is_roundtrip);
+
+	// То же по номерам уже добавленных остановок
+	void AddBus(const std::string& name, const std::vector<StopId>& stop_ids, bool is_roundtrip);
+
+	// Расстояния от остановки до соседних. Обратное направление хранится
+	// отдельно, если задано явно, иначе берется из прямого при поиске
+	void AddDistances(const std::string& stop_name, const std::vector<std::pair<std::string, int>>& distances);
+
+	// Маршрут по названию, nullptr если такого маршрута нет
+	const Bus* FindBus(const std::string& bus_name) const;
+
+	// Остановка по названию, nullptr если такой остановки нет
+	const Stop* FindStop(const std::string& stop_name) const;
+
+	const Stop& GetStop(StopId stop_id) const;
+
+	const Bus& GetBus(BusId bus_id) const;
 
 	int GetDistanceBetweenTwoStops(const std::string& first_stop_name, const std::string& second_stop_name);
 
-	std::shared_ptr<std::set<std::string>> GetStopToBuses(const std::string& stop_name) const;
+	// Расстояние между остановками по их номерам: сначала ищется расстояние
+	// в прямом направлении, затем в обратном. 0, если расстояние не задано
+	int GetDistanceBetweenTwoStops(graph::VertexId first_stop_id, graph::VertexId second_stop_id) const;
 
-	const std::map<std::string, std::shared_ptr<Stop>>& GetStops();
+	// Все остановки в порядке их номеров
+	StopsRange GetStops() const;
 
-	const std::map<std::string, std::shared_ptr<Bus>>& GetBuses();
+	// Все маршруты в порядке их номеров
+	BusesRange GetBuses() const;
 
-	const std::map<std::string, std::shared_ptr<std::set<std::string>>>& GetStopsToBuses();
+	// Номера остановок в порядке их названий
+	const std::vector<StopId>& GetStopsSortedByName() const;
 
-	const std::map<graph::VertexId, std::shared_ptr<Stop>>& GetStopIdToStops();
+	// Номера маршрутов в порядке их названий
+	const std::vector<BusId>& GetBusesSortedByName() const;
 
-	size_t GetStopsCount();
+	void SetBusStats(BusId bus_id, const BusStats& stats);
 
-	std::unordered_map<std::pair<std::shared_ptr<Stop>, std::shared_ptr<Stop>>, double, Hasher>& GetStopsPairToDistance();
+	size_t GetStopsCount() const;
 
-	std::shared_ptr<Stop> GetStopByName(const std::string& name);
+	const std::unordered_map<StopsPairKey, double>& GetDistances() const;
 
-	void SetDistancesBetweenCurrentStopAndAnother(const std::string& current_stop, const std::string another_name, double distance);
+	// Расстояние от остановки from до остановки to, перезаписывает прежнее
+	void SetDistance(StopId from, StopId to, double distance);
 
-private:
-	graph::VertexId stops_count_ = 0;
-	graph::VertexId buses_count_ = 0;
+	// Резервирует место под остановки и маршруты перед массовой загрузкой
+	void Reserve(size_t stops_count, size_t buses_count);
 
-	// stops_[название остановки] = указатель на остановку
-	std::map<std::string, std::shared_ptr<Stop>> stops_;
+private:
+	// stops_[номер остановки] = остановка
+	std::vector<Stop> stops_;
 
-	// buses_[название маршрута] = указатель на маршрут
-	std::map<std::string, std::shared_ptr<Bus>> buses_;
+	// buses_[номер маршрута] = маршрут
+	std::vector<Bus> buses_;
 
-	// stops_to_buses_[название остановки] = список названий маршрутов
-	std::map<std::string, std::shared_ptr<std::set<std::string>>> stops_to_buses_;
+	// stop_name_to_id_[название остановки] = номер остановки
+	std::unordered_map<std::string, StopId> stop_name_to_id_;
 
-	std::map<graph::VertexId, std::shared_ptr<Stop>> stop_id_to_stops_;
+	// bus_name_to_id_[название маршрута] = номер маршрута
+	std::unordered_map<std::string, BusId> bus_name_to_id_;
 
-	// stops_pair_to_distance_[две остановки] = расстояние между ними
-	std::unordered_map<std::pair<std::shared_ptr<Stop>, std::shared_ptr<Stop>>, double, Hasher> stops_pair_to_distance_;
+	// Номера в порядке названий, строятся при первом обращении
+	// и сбрасываются при добавлении остановок и маршрутов
+	mutable std::vector<StopId> stops_sorted_by_name_;
+	mutable std::vector<BusId> buses_sorted_by_name_;
 
-	void SetDistancesBetweenCurrentStopAndOtherOnes_(std::shared_ptr<Stop> current_stop, const std::vector<std::string>& words);
+	// distances_[PackStopsPair(номер, номер)] = расстояние между остановками
+	std::unordered_map<StopsPairKey, double> distances_;
 
 	void ReadDistanceAndStopNameFromString_(std::pair<int, std::string>& distance_and_name, const std::string& line);
 
-	std::shared_ptr<Stop> GetPointerToStopByName_(const std::string& stop_name);
+	// Номер остановки по названию, остановка создается, если ее еще нет
+	StopId GetOrAddStop_(const std::string& stop_name);
 };
\ No newline at end of file
@@ -3,174 +3,237 @@
 TransportRouter::TransportRouter(TransportCatalogue& transoprt_catalogue)
 	: transoprt_catalogue_(transoprt_catalogue) {
 		graph_ = std::make_shared<graph::DirectedWeightedGraph<double>>();
-		router_ = std::make_shared<graph::Router<double>>(*graph_.get());
+		router_ = std::make_shared<AllPairsRouter>(*graph_.get());
 }
 
 void TransportRouter::SetRouteSettings(const RouteSettings& route_settings) {
 	route_settings_ = route_settings;
 }
 
-// Обработка запроса
-void TransportRouter::ParseQuery(const std::string& stop_from, const std::string& stop_to, int request_id, json::Builder& json_builder) {
+// Обработка запроса. Ключи словарей передаются по возрастанию,
+// чтобы потоковый вывод совпадал с выводом дерева
+template <typename Target>
+void TransportRouter::ParseQuery(const std::string& stop_from, const std::string& stop_to, int request_id, Target& target) {
 	using namespace std::literals;
 
-	const auto& stops = transoprt_catalogue_.GetStops();
+	const Stop* from_stop = transoprt_catalogue_.FindStop(stop_from);
+	const Stop* to_stop = transoprt_catalogue_.FindStop(stop_to);
 
-	if (!stops.count(stop_from) || !stops.count(stop_to)) {
-		ExitWithEmptyResult_(request_id, json_builder);
+	if (from_stop == nullptr || to_stop == nullptr) {
+		ExitWithEmptyResult_(request_id, target);
 		return;
 	}
 
-	graph::VertexId from = stops.at(stop_from).get()->id;
-	graph::VertexId to = stops.at(stop_to).get()->id;
+	graph::VertexId from = from_stop->id;
+	graph::VertexId to = to_stop->id;
 
 	auto result = router_.get()->BuildRoute(from, to);
 	if (result == std::nullopt) {
-		ExitWithEmptyResult_(request_id, json_builder);
+		ExitWithEmptyResult_(request_id, target);
 		return;
 	}
 
-	json_builder.StartDict().Key("items"s).StartArray();
-
-	const auto& id_to_stop = transoprt_catalogue_.GetStopIdToStops();
-	for (int edge_num : (*result).edges) {
-		const auto& edge = graph_.get()->GetEdge(edge_num);
-
-		graph::VertexId id_from = edge.from;
-		graph::VertexId id_to = edge.to;
-
-		std::shared_ptr<Stop> stop_from = id_to_stop.at(id_from);
-		std::shared_ptr<Stop> stop_to = id_to_stop.at(id_to);
-
-		double waiting_time = edge.weight;
-		double hash = Hash_(stop_from.get()->id, stop_to.get()->id, waiting_time);
-		std::shared_ptr<Route> route = hash_to_route_.at(hash);
+	PrintItems_((*result).edges, target, json::TypedBuilder(target).StartDict().Key("items"sv).StartArray())
+		.EndArray()
+		.Key("request_id"sv).Value(request_id)
+		.Key("total_time"sv).Value((*result).weight)
+		.EndDict();
+}
 
-		json_builder.StartDict()
-			.Key("type"s).Value("Wait"s)
-			.Key("stop_name"s).Value(stop_from.get()->name)
-			.Key("time"s).Value(route_settings_.bus_wait_time)
-			.EndDict()
+// Создание графа на основе всевозможных путей в рамках каждого маршрута
+void TransportRouter::SetGraph() {
+	graph_ = std::make_shared<graph::DirectedWeightedGraph<double>>(GetVertexCount_(), SetEdges_());
 
-			.StartDict()
-			.Key("bus"s).Value(route.get()->bus_name)
-			.Key("span_count"s).Value(route.get()->span_count)
-			.Key("time"s).Value(waiting_time - route_settings_.bus_wait_time)
-			.Key("type"s).Value("Bus"s)
-			.EndDict();
+	SetRouter();
+}
 
+// Создание движка маршрутизации над уже построенным графом
+void TransportRouter::SetRouter() {
+	switch (route_settings_.router_type) {
+	case RouterType::ALL_PAIRS:
+		// Маршруты начинаются только в вершинах остановок, они идут первыми
+		router_ = std::make_shared<AllPairsRouter>(*graph_.get(), transoprt_catalogue_.GetStopsCount(), threads_count_);
+		break;
+	case RouterType::DIJKSTRA:
+		router_ = std::make_shared<graph::DijkstraRouter<double>>(*graph_.get(), route_settings_.route_cache_size);
+		break;
+	case RouterType::LAZY_ROWS:
+		router_ = std::make_shared<graph::LazyRouter<double>>(*graph_.get(), route_settings_.route_rows_limit);
+		break;
 	}
-
-	json_builder.EndArray()
-		.Key("request_id"s).Value(request_id)
-		.Key("total_time"s).Value((*result).weight)
-		.EndDict();
 }
 
-std::deque<std::shared_ptr<Route>> TransportRouter::SetHash(){
-	const std::map<std::string, std::shared_ptr<Bus>>& buses = transoprt_catalogue_.GetBuses();
-	std::deque<std::shared_ptr<Route>> all_possible_ways;
-
-	for (const auto& [bus_name, bus_ptr] : buses) {
+void TransportRouter::SetThreadsCount(size_t threads_count) {
+	threads_count_ = threads_count;
+}
 
-		size_t subvector_first_pos = all_possible_ways.size();
-		const std::deque<std::shared_ptr<Stop>>& stops = bus_ptr.get()->stops;
+RouteSettings& TransportRouter::GetRouteSettings(){
+	return route_settings_;
+}
 
-		for (int i = 0; i < static_cast<int>(stops.size()) - 1; ++i) {
+std::shared_ptr<graph::DirectedWeightedGraph<double>> TransportRouter::GetGraph(){
+	return graph_;
+}
 
-			std::shared_ptr<Stop> stop_from = stops.at(i);
-			std::shared_ptr<Stop> stop_to = stops.at(i + 1);
+std::vector<EdgeInfo>& TransportRouter::GetEdgesInfo(){
+	return edges_info_;
+}
 
-			graph::VertexId id_from = stop_from.get()->id;
-			graph::VertexId id_to = stop_to.get()->id;
+std::shared_ptr<graph::RouterBase<double>> TransportRouter::GetRouter(){
+	return router_;
+}
 
-			double waiting_time = CalculateTimeWithWaiting_(stop_from, stop_to);
-			double hash = Hash_(id_from, id_to, waiting_time);
-			hash_to_route_[hash] = std::make_shared<Route>(stop_from, stop_to,
-				CalculateTimeWithWaiting_(stop_from, stop_to), bus_name, 1);
+std::shared_ptr<AllPairsRouter> TransportRouter::GetAllPairsRouter(){
+	return std::dynamic_pointer_cast<AllPairsRouter>(router_);
+}
 
-			all_possible_ways.push_back(hash_to_route_.at(hash));
+// Расчет времени пути между остановками
+double TransportRouter::CalculateTime_(StopId stop_from, StopId stop_to) {
+	return transoprt_catalogue_.GetDistanceBetweenTwoStops(stop_from, stop_to) / route_settings_.bus_velocity;
+}
 
-		}
-		for (int i = 0; i < static_cast<int>(stops.size()) - 2; ++i) {
-			for (int j = i + 1; j < static_cast<int>(stops.size()) - 1; ++j) {
+std::vector<graph::Edge<double>> TransportRouter::SetEdges_() {
+	edges_info_.clear();
+	if (route_settings_.graph_model == GraphModel::STOP_AND_WAIT) {
+		return SetStopAndWaitEdges_();
+	}
+	return SetBusSpansEdges_();
+}
 
-				double hash;
-				std::shared_ptr<Route> route;
+// Ребра графа модели BUS_SPANS: из каждой остановки маршрута во все
+// следующие. Время поездки копится по ходу маршрута, поэтому каждый
+// перегон считается один раз для каждой остановки посадки
+std::vector<graph::Edge<double>> TransportRouter::SetBusSpansEdges_() {
+	std::vector<graph::Edge<double>> edges;
 
-				if (j == i + 1) {
-					route = SumRoutes_(all_possible_ways.at(subvector_first_pos + i), all_possible_ways.at(subvector_first_pos + i + 1), bus_name);
-				} else {
-					route = SumRoutes_(all_possible_ways.back(), all_possible_ways.at(subvector_first_pos + j), bus_name);
-				}
+	for (BusId bus_id : transoprt_catalogue_.GetBusesSortedByName()) {
+		const std::vector<StopId>& stops = transoprt_catalogue_.GetBus(bus_id).stops;
 
-				hash = Hash_(route.get()->stop_from.get()->id, route.get()->stop_to.get()->id, route.get()->waiting_time);
-				hash_to_route_[hash] = route;
-				all_possible_ways.push_back(route);
+		for (size_t i = 0; i + 1 < stops.size(); ++i) {
+			const graph::VertexId id_from = stops[i];
+			double ride_time = 0;
 
+			for (size_t j = i + 1; j < stops.size(); ++j) {
+				ride_time += CalculateTime_(stops[j - 1], stops[j]);
+				edges.push_back({ id_from, stops[j], route_settings_.bus_wait_time + ride_time });
+				edges_info_.push_back({ EdgeType::SPAN, id_from, bus_id, static_cast<int>(j - i) });
 			}
 		}
 	}
 
-	return all_possible_ways;
+	return edges;
 }
 
-// Создание графа на основе всевозможных путей в рамках каждого маршрута
-void TransportRouter::SetGraph() {
-	std::deque<std::shared_ptr<Route>> all_possible_ways = SetHash();
+// Ребра графа модели STOP_AND_WAIT. Вершины 0..stops_count-1 - ожидание
+// на остановках, далее идут вершины позиций маршрутов в порядке их названий.
+// Для позиции i маршрута: посадка (остановка -> позиция, вес - время ожидания),
+// перегон (позиция i -> позиция i + 1) и высадка (позиция -> остановка, вес 0)
+std::vector<graph::Edge<double>> TransportRouter::SetStopAndWaitEdges_() {
+	std::vector<graph::Edge<double>> edges;
 
-	graph_ = std::make_shared<graph::DirectedWeightedGraph<double>>(transoprt_catalogue_.GetStopsCount());
-	while (!all_possible_ways.empty()) {
-		std::shared_ptr<Route> route_struct = all_possible_ways.front();
-		graph_.get()->AddEdge({ route_struct.get()->stop_from.get()->id, route_struct.get()->stop_to.get()->id, route_struct.get()->waiting_time });
-		all_possible_ways.pop_front();
-	}
+	graph::VertexId position_vertex = transoprt_catalogue_.GetStopsCount();
+	for (BusId bus_id : transoprt_catalogue_.GetBusesSortedByName()) {
+		const std::vector<StopId>& stops = transoprt_catalogue_.GetBus(bus_id).stops;
 
-	router_ = std::make_shared<graph::Router<double>>(*graph_.get());
+		for (size_t i = 0; i < stops.size(); ++i, ++position_vertex) {
+			const graph::VertexId stop_id = stops[i];
 
-}
-
-RouteSettings& TransportRouter::GetRouteSettings(){
-	return route_settings_;
-}
+			if (i + 1 < stops.size()) {
+				edges.push_back({ stop_id, position_vertex, static_cast<double>(route_settings_.bus_wait_time) });
+				edges_info_.push_back({ EdgeType::BOARD, stop_id, bus_id, 0 });
 
-std::shared_ptr<graph::DirectedWeightedGraph<double>> TransportRouter::GetGraph(){
-	return graph_;
-}
+				edges.push_back({ position_vertex, position_vertex + 1, CalculateTime_(stops[i], stops[i + 1]) });
+				edges_info_.push_back({ EdgeType::RIDE, stop_id, bus_id, 1 });
+			}
+			if (i > 0) {
+				edges.push_back({ position_vertex, stop_id, 0.0 });
+				edges_info_.push_back({ EdgeType::ALIGHT, stop_id, bus_id, 0 });
+			}
+		}
+	}
 
-std::shared_ptr<graph::Router<double>> TransportRouter::GetRouter(){
-	return router_;
+	return edges;
 }
 
-// Расчет времени пути между остановками с учетом времени ожидания
-double TransportRouter::CalculateTimeWithWaiting_(const std::shared_ptr<Stop> stop_from, const std::shared_ptr<Stop> stop_to) {
-	return CalculateTime_(stop_from, stop_to) + route_settings_.bus_wait_time;
+// В модели BUS_SPANS вершины - только остановки, в модели STOP_AND_WAIT
+// к ним добавляются все позиции всех маршрутов
+size_t TransportRouter::GetVertexCount_() {
+	size_t vertex_count = transoprt_catalogue_.GetStopsCount();
+	if (route_settings_.graph_model == GraphModel::BUS_SPANS) {
+		return vertex_count;
+	}
+	for (const Bus& bus : transoprt_catalogue_.GetBuses()) {
+		vertex_count += bus.stops.size();
+	}
+	return vertex_count;
 }
 
-// Расчет времени пути между остановками
-double TransportRouter::CalculateTime_(const std::shared_ptr<Stop> stop_from, const std::shared_ptr<Stop> stop_to) {
-	return transoprt_catalogue_.GetDistanceBetweenTwoStops(stop_from.get()->name, stop_to.get()->name) / route_settings_.bus_velocity;
-}
+// Ребро SPAN дает пару элементов Wait и Bus. В модели STOP_AND_WAIT
+// подряд идущие перегоны одного автобуса между посадкой
+// и высадкой собираются в один элемент Bus.
+// Элементы пишутся в уже открытый массив items, который затем
+// возвращается для продолжения цепочки вызовов
+template <typename Target, typename Items>
+Items TransportRouter::PrintItems_(const std::vector<graph::EdgeId>& edges, Target& target, Items items) {
+	using namespace std::literals;
 
-// Сложение маршрутов с общими остановками
-std::shared_ptr<Route> TransportRouter::SumRoutes_(const std::shared_ptr<Route> left, const std::shared_ptr<Route> right, const std::string& bus_name) {
-	return std::make_shared<Route>(left.get()->stop_from, right.get()->stop_to,
-		left.get()->waiting_time + right.get()->waiting_time - route_settings_.bus_wait_time,
-		bus_name, left.get()->span_count + right.get()->span_count);
-}
+	int span_count = 0;
+	double ride_time = 0;
 
-// Расчет хэша структуры маршрута
-double TransportRouter::Hash_(graph::VertexId id_from, graph::VertexId id_to, double waiting_time) {
-	return 12.0 * id_from + 250.0 * id_to +
-		static_cast<double>(id_from) * static_cast<double>(id_to) +
-		123.0 * waiting_time + static_cast<double>(id_to) * waiting_time;
+	auto print_wait = [&](const EdgeInfo& edge_info) {
+		json::TypedBuilder(target).StartDict()
+			.Key("stop_name"sv).Value(transoprt_catalogue_.GetStop(edge_info.stop_id).name)
+			.Key("time"sv).Value(route_settings_.bus_wait_time)
+			.Key("type"sv).Value("Wait"s)
+			.EndDict();
+	};
+	auto print_bus = [&](const EdgeInfo& edge_info, int bus_span_count, double time) {
+		json::TypedBuilder(target).StartDict()
+			.Key("bus"sv).Value(transoprt_catalogue_.GetBus(edge_info.bus_id).name)
+			.Key("span_count"sv).Value(bus_span_count)
+			.Key("time"sv).Value(time)
+			.Key("type"sv).Value("Bus"s)
+			.EndDict();
+	};
+
+	for (graph::EdgeId edge_id : edges) {
+		const EdgeInfo& edge_info = edges_info_.at(edge_id);
+		const double edge_weight = graph_.get()->GetEdge(edge_id).weight;
+
+		switch (edge_info.type) {
+		case EdgeType::SPAN:
+			print_wait(edge_info);
+			print_bus(edge_info, edge_info.span_count, edge_weight - route_settings_.bus_wait_time);
+			break;
+		case EdgeType::BOARD:
+			print_wait(edge_info);
+			span_count = 0;
+			ride_time = 0;
+			break;
+		case EdgeType::RIDE:
+			span_count += edge_info.span_count;
+			ride_time += edge_weight;
+			break;
+		case EdgeType::ALIGHT:
+			print_bus(edge_info, span_count, ride_time);
+			break;
+		}
+	}
+	return items;
 }
 
-void TransportRouter::ExitWithEmptyResult_(int request_id, json::Builder& json_builder) {
+template <typename Target>
+void TransportRouter::ExitWithEmptyResult_(int request_id, Target& target) {
 	using namespace std::literals;
 
-	json_builder.StartDict()
-		.Key("request_id"s).Value(request_id)
-		.Key("error_message"s).Value("not found"s)
+	json::TypedBuilder(target).StartDict()
+		.Key("error_message"sv).Value("not found"s)
+		.Key("request_id"sv).Value(request_id)
 		.EndDict();
-}
\ No newline at end of file
+}
+
+// Цели, для которых собирается ParseQuery
+template void TransportRouter::ParseQuery<json::NodeTarget>(const std::string& stop_from, const std::string& stop_to,
+	int request_id, json::NodeTarget& target);
+template void TransportRouter::ParseQuery<json::Writer>(const std::string& stop_from, const std::string& stop_to,
+	int request_id, json::Writer& target);
\ No newline at end of file
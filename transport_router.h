@@ -9,31 +9,58 @@
 #include <memory>
 #include <algorithm>
 #include <deque>
+#include <string_view>
+#include <vector>
 
 #include "transport_catalogue.h"
 #include "json_builder.h"
 #include "router.h"
+#include "dijkstra_router.h"
+
+// Движок построения маршрутов
+enum class RouterType {
+	ALL_PAIRS, // предрасчет всех пар вершин при построении базы
+	DIJKSTRA,  // поиск по запросу с кэшем последних ответов
+	LAZY_ROWS  // дерево кратчайших путей строится при первом запросе из вершины
+};
+
+// Движок с предрасчетом всех пар: веса в матрице хранятся во float,
+// чтобы матрица занимала вдвое меньше памяти
+using AllPairsRouter = graph::Router<double, float>;
+
+// Способ построения графа
+enum class GraphModel {
+	// вершина - остановка, ребро - поездка на автобусе от остановки i до любой
+	// следующей остановки j того же маршрута вместе с ожиданием (O(k^2) ребер на маршрут)
+	BUS_SPANS,
+	// вершина ожидания на каждой остановке и вершина на каждой позиции каждого маршрута:
+	// посадка, перегон до следующей остановки и высадка (O(k) ребер на маршрут)
+	STOP_AND_WAIT
+};
 
 struct RouteSettings {
 	int bus_wait_time; // мин
 	double bus_velocity; // м/мин
+	RouterType router_type = RouterType::ALL_PAIRS;
+	size_t route_cache_size = 100000; // размер кэша ответов движка DIJKSTRA
+	size_t route_rows_limit = 0; // число хранимых строк движка LAZY_ROWS, 0 - без ограничения
+	GraphModel graph_model = GraphModel::BUS_SPANS;
 };
 
-struct Route {
-	Route() = default;
-
-	Route(std::shared_ptr<Stop> stop_from, std::shared_ptr<Stop> stop_to, double waiting_time,
-		const std::string& bus_name, int span_count)
-		: stop_from(stop_from), stop_to(stop_to), waiting_time(waiting_time),
-		bus_name(bus_name), span_count(span_count) {
-
-	}
+// Тип ребра графа
+enum class EdgeType {
+	SPAN,   // ожидание и поездка на span_count перегонов (модель BUS_SPANS)
+	BOARD,  // ожидание автобуса и посадка (модель STOP_AND_WAIT)
+	RIDE,   // перегон до следующей остановки маршрута (модель STOP_AND_WAIT)
+	ALIGHT  // высадка на остановке (модель STOP_AND_WAIT)
+};
 
-	std::shared_ptr<Stop> stop_from;
-	std::shared_ptr<Stop> stop_to;
-	double waiting_time;
-	const std::string& bus_name;
-	int span_count;
+// Сведения о ребре графа, нужные для вывода маршрута
+struct EdgeInfo {
+	EdgeType type;
+	graph::VertexId stop_id; // остановка, с которой начинается ребро
+	graph::VertexId bus_id;
+	int span_count = 0;
 };
 
 
@@ -43,38 +70,61 @@ public:
 
 	void SetRouteSettings(const RouteSettings& route_settings);
 
-	// Обработка запроса
-	void ParseQuery(const std::string& stop_from, const std::string& stop_to, int request_id, json::Builder& json_builder);
-
-	std::deque<std::shared_ptr<Route>> SetHash();
+	// Обработка запроса: ответ пишется одним значением в target -
+	// json::NodeTarget или json::Writer (см. json::TypedBuilder)
+	template <typename Target>
+	void ParseQuery(const std::string& stop_from, const std::string& stop_to, int request_id, Target& target);
 
 	// Создание графа на основе всевозможных путей в рамках каждого маршрута
+	// и движка маршрутизации, выбранного в route_settings_.router_type
 	void SetGraph();
 
+	// Создание движка маршрутизации над уже построенным графом
+	void SetRouter();
+
+	// Число потоков для предрасчета движка ALL_PAIRS
+	void SetThreadsCount(size_t threads_count);
+
 	RouteSettings& GetRouteSettings();
 
 	std::shared_ptr<graph::DirectedWeightedGraph<double>> GetGraph();
 
-	std::shared_ptr<graph::Router<double>> GetRouter();
+	// Сведения о ребрах графа, сохраняются в базу вместе с графом
+	std::vector<EdgeInfo>& GetEdgesInfo();
+
+	std::shared_ptr<graph::RouterBase<double>> GetRouter();
+
+	// Движок с предрасчетом всех пар или nullptr, если выбран другой движок
+	std::shared_ptr<AllPairsRouter> GetAllPairsRouter();
 
 private:
 	RouteSettings route_settings_;
 	std::shared_ptr<graph::DirectedWeightedGraph<double>> graph_;
-	std::shared_ptr<graph::Router<double>> router_;
+	std::shared_ptr<graph::RouterBase<double>> router_;
+	size_t threads_count_ = 1;
 	TransportCatalogue& transoprt_catalogue_;
-	std::map<double, std::shared_ptr<Route>> hash_to_route_;
+	// edges_info_[номер ребра] = сведения о ребре
+	std::vector<EdgeInfo> edges_info_;
 
-	// Расчет времени пути между остановками с учетом времени ожидания
-	double CalculateTimeWithWaiting_(const std::shared_ptr<Stop> stop_from, const std::shared_ptr<Stop> stop_to);
+	// Ребра графа выбранной модели, заодно заполняет edges_info_
+	std::vector<graph::Edge<double>> SetEdges_();
 
-	// Расчет времени пути между остановками
-	double CalculateTime_(const std::shared_ptr<Stop> stop_from, const std::shared_ptr<Stop> stop_to);
+	// Ребра графа модели BUS_SPANS
+	std::vector<graph::Edge<double>> SetBusSpansEdges_();
+
+	// Ребра графа модели STOP_AND_WAIT
+	std::vector<graph::Edge<double>> SetStopAndWaitEdges_();
 
-	// Сложение маршрутов с общими остановками
-	std::shared_ptr<Route> SumRoutes_(const std::shared_ptr<Route> left, const std::shared_ptr<Route> right, const std::string& bus_name);
+	// Число вершин графа выбранной модели
+	size_t GetVertexCount_();
 
-	// Расчет хэша структуры маршрута
-	double Hash_(graph::VertexId id_from, graph::VertexId id_to, double waiting_time);
+	// Вывод элементов маршрута по его ребрам
+	template <typename Target, typename Items>
+	Items PrintItems_(const std::vector<graph::EdgeId>& edges, Target& target, Items items);
+
+	// Расчет времени пути между остановками
+	double CalculateTime_(StopId stop_from, StopId stop_to);
 
-	void ExitWithEmptyResult_(int request_id, json::Builder& json_builder);
+	template <typename Target>
+	void ExitWithEmptyResult_(int request_id, Target& target);
 };
\ No newline at end of file